@@ -0,0 +1,78 @@
+#include "apsp.hpp"
+
+#include <cassert>
+#include <iostream>
+
+#include "graph_generators.hpp"
+
+// Both methods against Bellman-Ford from every node, on sizes that aren't a
+// whole number of tiles (so the padding gets exercised), on one thread and
+// several.
+
+static std::vector<double> bellman_ford(const frozen_graph<std::uint64_t> &g, node_id source) {
+    auto distance = std::vector<double>(g.node_count(), HUGE_VAL);
+    distance[source] = 0;
+    for(node_id round = 0; round < g.node_count(); ++round) {
+        for(node_id u = 0; u < g.node_count(); ++u) {
+            if(distance[u] == HUGE_VAL) {
+                continue;
+            }
+            g.for_each_out_edge(u, [&](node_id v, double w) {
+                distance[v] = std::min(distance[v], distance[u] + w);
+            });
+        }
+    }
+    return distance;
+}
+
+static void check(const frozen_graph<std::uint64_t> &g, const distance_matrix &distances) {
+    assert(distances.size() == g.node_count());
+    for(node_id source = 0; source < g.node_count(); ++source) {
+        auto expected = bellman_ford(g, source);
+        auto row = distances.row(source);
+        for(node_id target = 0; target < g.node_count(); ++target) {
+            if(expected[target] == HUGE_VAL) {
+                assert(row[target] == HUGE_VAL);
+            } else {
+                assert(std::abs(row[target] - expected[target]) < 1e-9 * (1 + std::abs(expected[target])));
+            }
+        }
+    }
+}
+
+static void check_both(const frozen_graph<std::uint64_t> &g, distance_matrix &distances, thread_pool &pool) {
+    floyd_warshall(g, distances, pool);
+    check(g, distances);
+    repeated_dijkstra(g, distances, pool);
+    check(g, distances);
+}
+
+void testApsp() {
+    std::cerr << "Initializing all pairs shortest path tests" << std::endl;
+    auto pool = thread_pool(4);
+    auto serial = thread_pool(1);
+    auto distances = distance_matrix();
+
+    for(node_id nodes : {1u, 2u, 63u, 65u, 150u}) {
+        check_both(freeze(erdos_renyi_graph(nodes, 3, nodes)), distances, pool);
+    }
+    auto rmat = freeze(rmat_graph(7, 8));
+    check_both(rmat, distances, pool);
+    check_both(rmat, distances, serial);
+
+    // Reusing the matrix at the same size doesn't reallocate it.
+    auto data = distances.data();
+    all_pairs_shortest_paths(rmat, distances, pool);
+    assert(distances.data() == data);
+
+    // Dense graphs go to Floyd-Warshall, sparse ones to Dijkstra.
+    auto dense = freeze(erdos_renyi_graph(100, 50));
+    assert(all_pairs_shortest_paths(dense, distances, pool) == apsp_method::floyd_warshall);
+    check(dense, distances);
+    assert(all_pairs_shortest_paths(rmat, distances, pool) == apsp_method::repeated_dijkstra);
+    check(rmat, distances);
+
+    auto empty = freeze(generated_graph());
+    all_pairs_shortest_paths(empty, distances, pool);
+    assert(distances.size() == 0);
+}
@@ -0,0 +1,210 @@
+#ifndef APSP_H
+#define APSP_H
+
+#include <algorithm>
+#include <cmath>
+#include <span>
+#include <vector>
+
+#include "dijkstra_workspace.hpp"
+#include "frozen_graph.hpp"
+#include "thread_pool.hpp"
+
+// All pairs shortest paths, for filling in full distance tables over small
+// graphs (up to ten thousand nodes or so:  the table itself is n^2 doubles,
+// 800MB at that size).  They work over the dense graph types, so a
+// graph<T> gets frozen first, and frozen_graph's id() and name() then map
+// between node names and rows and columns of the table.
+//
+// There are two ways of doing it, and which is faster depends on how dense
+// the graph is.
+//
+// floyd_warshall does n^3 steps whatever the graph, but each one is just
+// an add and a min over a plain array, which the compiler can turn into
+// SIMD instructions.  It's blocked (Venkataraman, Sahni and Mukhopadhyaya,
+// "A Blocked All-Pairs Shortest-Paths Algorithm", 2003):  the table is cut
+// into 64 by 64 tiles, and each round of 64 values of k goes through it in
+// three phases:  first the tile on the diagonal (which only depends on
+// itself), then the rest of its tile row and column (which only depend on
+// themselves and the diagonal tile), then every other tile, which depends
+// only on its own row's and column's tiles, so those can all go in
+// parallel.  A tile is 32KB, so the three tiles an update touches stay in
+// cache for all 64 * 64 * 64 steps of it.
+//
+// repeated_dijkstra runs Dijkstra from every node, in parallel with a
+// dijkstra_workspace per pool worker, which is about n * m log n steps and
+// so much better on sparse graphs.  (This is Johnson's algorithm without
+// its first half:  the reweighting that makes negative weights safe for
+// Dijkstra isn't needed, since the graphs don't allow them.)
+//
+// all_pairs_shortest_paths picks between them by how dense the graph is.
+// Either way, the answer goes in a distance_matrix the caller provides, so
+// a caller refreshing the table over and over doesn't reallocate it.
+
+// An n by n table of distances, with +infinity for "unreachable".  Rows
+// are padded to a whole number of tiles, for floyd_warshall.
+class distance_matrix {
+public:
+    static constexpr size_t tile = 64;
+
+private:
+    node_id n = 0;
+    size_t row_stride = 0;
+    std::vector<double> values;
+
+public:
+    distance_matrix() = default;
+
+    explicit distance_matrix(node_id size) {
+        resize(size);
+    }
+
+    // Only allocates if the matrix has to grow.
+    void resize(node_id size) {
+        n = size;
+        row_stride = (size_t(size) + tile - 1) / tile * tile;
+        values.resize(row_stride * row_stride);
+    }
+
+    node_id size() const {
+        return n;
+    }
+
+    size_t stride() const {
+        return row_stride;
+    }
+
+    double operator()(node_id from, node_id to) const {
+        return values[from * row_stride + to];
+    }
+
+    double &operator()(node_id from, node_id to) {
+        return values[from * row_stride + to];
+    }
+
+    // The distances from one node to every node.
+    std::span<const double> row(node_id from) const {
+        return {values.data() + from * row_stride, n};
+    }
+
+    double *data() {
+        return values.data();
+    }
+};
+
+enum class apsp_method {
+    automatic,
+    floyd_warshall,
+    repeated_dijkstra
+};
+
+// c[i][j] = min(c[i][j], a[i][k] + b[k][j]) over one tile of each, for
+// each k in order (so c may be the same tile as a or b).  The row of b is
+// copied out first so the compiler can see it doesn't overlap c, and the
+// fixed trip count lets it vectorize the inner loop even at -O2.
+inline void relax_tile(double *c, const double *a, const double *b, size_t stride) {
+    constexpr auto tile = distance_matrix::tile;
+    double b_row[tile];
+    for(size_t k = 0; k < tile; ++k) {
+        std::copy(b + k * stride, b + k * stride + tile, b_row);
+        for(size_t i = 0; i < tile; ++i) {
+            auto a_ik = a[i * stride + k];
+            if(a_ik == HUGE_VAL) {
+                continue;
+            }
+            auto c_row = c + i * stride;
+            for(size_t j = 0; j < tile; ++j) {
+                c_row[j] = std::min(c_row[j], a_ik + b_row[j]);
+            }
+        }
+    }
+}
+
+template <class Graph>
+void floyd_warshall(const Graph &g, distance_matrix &distances, thread_pool &pool) {
+    constexpr auto tile = distance_matrix::tile;
+    auto n = g.node_count();
+    distances.resize(n);
+    auto stride = distances.stride();
+    auto data = distances.data();
+    std::fill(data, data + stride * stride, HUGE_VAL);
+    for(node_id u = 0; u < n; ++u) {
+        distances(u, u) = 0;
+        g.for_each_out_edge(u, [&](node_id v, double weight) {
+            distances(u, v) = std::min(distances(u, v), weight);
+        });
+    }
+
+    auto tiles = stride / tile;
+    auto at = [&](size_t row, size_t column) {
+        return data + row * tile * stride + column * tile;
+    };
+    for(size_t k = 0; k < tiles; ++k) {
+        auto diagonal = at(k, k);
+        relax_tile(diagonal, diagonal, diagonal, stride);
+        // Tasks 0..tiles - 1 are the tile row, the rest the tile column.
+        pool.parallel_for(2 * tiles, [&](unsigned, size_t task) {
+            auto other = task % tiles;
+            if(other == k) {
+                return;
+            }
+            if(task < tiles) {
+                auto c = at(k, other);
+                relax_tile(c, diagonal, c, stride);
+            } else {
+                auto c = at(other, k);
+                relax_tile(c, c, diagonal, stride);
+            }
+        }, 1);
+        pool.parallel_for(tiles * tiles, [&](unsigned, size_t task) {
+            auto row = task / tiles;
+            auto column = task % tiles;
+            if(row == k || column == k) {
+                return;
+            }
+            relax_tile(at(row, column), at(row, k), at(k, column), stride);
+        }, 1);
+    }
+}
+
+template <class Graph>
+void repeated_dijkstra(const Graph &g, distance_matrix &distances, thread_pool &pool) {
+    auto n = g.node_count();
+    distances.resize(n);
+    auto workspaces = std::vector<dijkstra_workspace>(pool.size());
+    pool.parallel_for(n, [&](unsigned worker, size_t i) {
+        auto source = node_id(i);
+        auto &workspace = workspaces[worker];
+        workspace.run(g, source);
+        for(node_id target = 0; target < n; ++target) {
+            distances(source, target) = workspace.distance(target);
+        }
+    }, 1);
+}
+
+// Picks floyd_warshall when the graph has at least dense_fraction * n^2
+// edges, otherwise repeated_dijkstra, and returns which it used.  The
+// default is where the two cross over in the apsp benchmark.
+template <class Graph>
+apsp_method all_pairs_shortest_paths(const Graph &g, distance_matrix &distances, thread_pool &pool,
+                                     apsp_method method = apsp_method::automatic, double dense_fraction = 0.1) {
+    if(method == apsp_method::automatic) {
+        auto n = g.node_count();
+        size_t edges = 0;
+        for(node_id u = 0; u < n; ++u) {
+            g.for_each_out_edge(u, [&](node_id, double) { edges++; });
+        }
+        method = double(edges) >= dense_fraction * double(n) * double(n) ? apsp_method::floyd_warshall
+                                                                          : apsp_method::repeated_dijkstra;
+    }
+    if(method == apsp_method::floyd_warshall) {
+        floyd_warshall(g, distances, pool);
+    } else {
+        repeated_dijkstra(g, distances, pool);
+    }
+    return method;
+}
+
+void testApsp();
+
+#endif //APSP_H
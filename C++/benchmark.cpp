@@ -0,0 +1,630 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <numeric>
+#include <random>
+#include <vector>
+
+#include "apsp.hpp"
+#include "bfs.hpp"
+#include "binary_graph.hpp"
+#include "compressed_graph.hpp"
+#include "dfs.hpp"
+#include "dijkstra_workspace.hpp"
+#include "dynamic_sssp.hpp"
+#include "graph_generators.hpp"
+#include "graph_reordering.hpp"
+#include "graph_loaders.hpp"
+#include "graph.hpp"
+#include "perf_counters.hpp"
+#include "reachability.hpp"
+#include "traversal_generator.hpp"
+
+// Timing comparisons, built as a separate executable (graph_benchmark) so
+// that the tests stay quick.  Usage:
+//
+// graph_benchmark [--filter=text] [nodes...]
+//
+// Each benchmark case is run at each graph size given (sizes like 1e6 are
+// fine;  the default is 1e3, 1e4 and 1e5), skipping the cases whose name
+// doesn't contain the filter text.  Anything else, or a size past the
+// largest any case runs at, prints the usage and exits with status 2.
+//
+// Most cases build a random graph with about four edges per node and
+// compare ways of doing something with it.  The generators/ cases instead
+// build each kind of synthetic graph (see graph_generators.hpp) and
+// measure the basics on it:  build time, memory per edge, full traversal
+// time and point to point query latency.
+//
+// Some cases can't go to big sizes (dijkstra_traversal is quadratic, and
+// graph<T> needs far more memory per edge than the frozen forms), so each
+// case has a largest size it runs at.
+//
+// Where the hardware counters are available (see perf_counters.hpp), the
+// full traversals also report instructions, cache misses, branch misses and
+// dTLB misses per edge relaxed, which is what to look at when judging a
+// change to the memory layout:  it's far less noisy than the time.
+
+using benchmark_clock = std::chrono::steady_clock;
+
+// Runs traverse() (which returns the number of steps it took) repeatedly
+// for at least a quarter of a second, and reports the time per step.
+template <class F>
+static void report(const char *name, F &&traverse) {
+    size_t steps = 0;
+    size_t runs = 0;
+    auto start = benchmark_clock::now();
+    auto elapsed = benchmark_clock::duration::zero();
+    while(elapsed < std::chrono::milliseconds(250)) {
+        steps += traverse();
+        runs++;
+        elapsed = benchmark_clock::now() - start;
+    }
+    auto ns = std::chrono::duration<double, std::nano>(elapsed).count();
+    std::cout << "  " << name << ": " << ns / double(steps) << " ns/step, "
+              << ns / double(runs) / 1e6 << " ms/traversal" << std::endl;
+}
+
+static perf_counters counters;
+
+// Runs traverse() a few times under the hardware counters, and reports
+// them per edge relaxed, given how many edges one run relaxes (from a run
+// with traversal_stats:  the counted run itself is left uninstrumented).
+template <class F>
+static void report_counters(const char *name, size_t edges_relaxed, F &&traverse) {
+    if(!counters.any_available() || edges_relaxed == 0) {
+        return;
+    }
+    const int runs = 5;
+    traverse();
+    counters.start();
+    for(auto run = 0; run < runs; ++run) {
+        traverse();
+    }
+    auto sample = counters.stop();
+    std::cout << "  " << name << " per edge relaxed:";
+    for(size_t c = 0; c < perf_counters::counter_count; ++c) {
+        auto which = perf_counters::counter(c);
+        if(sample.available(which)) {
+            std::cout << " " << double(sample[which]) / double(runs) / double(edges_relaxed) << " "
+                      << perf_counters::counter_names[c] << ";";
+        }
+    }
+    std::cout << std::endl;
+}
+
+// A full dijkstra_workspace run from source, timed and then counted.
+template <class Graph>
+static void report_workspace(const char *name, const Graph &g, node_id source, dijkstra_workspace &workspace) {
+    auto traverse = [&] {
+        workspace.run(g, source);
+        return workspace.settled_count();
+    };
+    report(name, traverse);
+    auto stats = traversal_stats();
+    workspace.run(g, source, stats);
+    report_counters(name, stats.edges_relaxed, traverse);
+}
+
+static void benchmark_traversals(int nodes) {
+    std::cout << "Traversals over " << nodes << " nodes" << std::endl;
+    auto g = build_graph<int>(erdos_renyi_graph(nodes, 4));
+
+    auto traverse = [&] {
+        size_t steps = 0;
+        for(auto step : dijkstra_traversal<int>(g, 0)) {
+            steps++;
+        }
+        return steps;
+    };
+    report("dijkstra_traversal (iterator)", traverse);
+    auto stats = traversal_stats();
+    for([[maybe_unused]] auto &step : dijkstra_traversal<int, true>(g, 0, stats)) {
+    }
+    report_counters("dijkstra_traversal (iterator)", stats.edges_relaxed, traverse);
+    report("dijkstra_generator (coroutine)", [&] {
+        size_t steps = 0;
+        for([[maybe_unused]] auto &step : dijkstra_generator<int>(g, 0)) {
+            steps++;
+        }
+        return steps;
+    });
+    alignas(std::max_align_t) std::byte buffer[4096];
+    auto arena = frame_arena(buffer);
+    report("dijkstra_generator (coroutine, frame_arena)", [&] {
+        size_t steps = 0;
+        for([[maybe_unused]] auto &step : dijkstra_generator<int>(std::allocator_arg, arena, g, 0)) {
+            steps++;
+        }
+        return steps;
+    });
+}
+
+// Startup cost:  building a graph from scratch (and freezing it) against
+// mapping an already written binary graph file, and against parsing the
+// same graph as a text edge list (reported as MB/s, to compare with what
+// the disk can deliver).
+static void benchmark_loading(int nodes) {
+    std::cout << "Loading " << nodes << " nodes" << std::endl;
+    auto start = benchmark_clock::now();
+    auto g = build_graph<int>(erdos_renyi_graph(nodes, 4));
+    auto frozen = frozen_graph<int>(*g);
+    auto built = benchmark_clock::now() - start;
+    start = benchmark_clock::now();
+    g.reset();
+    auto destroyed = benchmark_clock::now() - start;
+
+    auto path = (std::filesystem::temp_directory_path() / "graph_benchmark.bin").string();
+    write_binary_graph(frozen, path);
+    start = benchmark_clock::now();
+    auto mapped = mapped_graph<int>(path);
+    auto loaded = benchmark_clock::now() - start;
+    std::filesystem::remove(path);
+
+    auto text_path = (std::filesystem::temp_directory_path() / "graph_benchmark.txt").string();
+    {
+        auto out = std::ofstream(text_path);
+        for(node_id u = 0; u < frozen.node_count(); ++u) {
+            frozen.for_each_out_edge(u, [&](node_id v, double w) {
+                out << frozen.name(u) << ' ' << frozen.name(v) << ' ' << w << '\n';
+            });
+        }
+    }
+    auto pool = thread_pool();
+    auto text = mapped_file(text_path);
+    start = benchmark_clock::now();
+    auto parsed = parse_edge_list(text.text(), pool);
+    auto parse_time = benchmark_clock::now() - start;
+    std::filesystem::remove(text_path);
+
+    std::cout << "  create_node/create_link + freeze: "
+              << std::chrono::duration<double, std::milli>(built).count() << " ms" << std::endl;
+    std::cout << "  ~graph: "
+              << std::chrono::duration<double, std::milli>(destroyed).count() << " ms" << std::endl;
+    std::cout << "  mapped_graph: "
+              << std::chrono::duration<double, std::milli>(loaded).count() << " ms" << std::endl;
+    auto parse_ms = std::chrono::duration<double, std::milli>(parse_time).count();
+    std::cout << "  parse_edge_list (" << parsed.edge_count() << " edges): " << parse_ms << " ms, "
+              << double(text.size()) / 1e3 / parse_ms << " MB/s" << std::endl;
+}
+
+// Memory against speed:  the same full traversal (a dijkstra_workspace run)
+// over a frozen_graph and over its compressed_graph, with the bytes each
+// spends per edge on its adjacency.
+static void benchmark_compression(int nodes) {
+    std::cout << "Compression over " << nodes << " nodes" << std::endl;
+    auto frozen = freeze<int>(erdos_renyi_graph(nodes, 4));
+    auto compressed = compressed_graph<int>(frozen);
+    auto edges = double(frozen.edge_count());
+    // Targets, weights, sources and back-pointers, plus both offset arrays.
+    auto frozen_bytes = edges * (2 * sizeof(node_id) + sizeof(double) + sizeof(edge_id)) +
+                        2.0 * (nodes + 1) * sizeof(edge_id);
+    std::cout << "  frozen_graph: " << frozen_bytes / edges << " bytes/edge" << std::endl;
+    std::cout << "  compressed_graph: " << double(compressed.adjacency_bytes()) / edges << " bytes/edge"
+              << (compressed.exact_weights() ? " (exact weights)" : " (quantized weights)") << std::endl;
+
+    auto workspace = dijkstra_workspace();
+    report_workspace("dijkstra_workspace (frozen_graph)", frozen, 0, workspace);
+    report_workspace("dijkstra_workspace (compressed_graph)", compressed, 0, workspace);
+}
+
+// Cache locality:  the same full traversal over a graph with its ids
+// scrambled and in each of the reorderings, with the mean id gap across an
+// edge as a measure of how local each order is.  A grid and a random
+// geometric graph have locality for the reorderings to recover;  an
+// Erdos-Renyi graph has none, and is there as the control.  The gains only
+// show once the graph is too big for the cache.
+static void benchmark_reordering(int nodes) {
+    auto workspace = dijkstra_workspace();
+    auto compare = [&](const char *kind, generated_graph generated) {
+        std::cout << "Reordering " << generated.node_count << " nodes (" << kind << ")" << std::endl;
+        // The generators number grid nodes row by row, which is already a
+        // good order, so shuffle them.  (Geometric and Erdos-Renyi ids have
+        // nothing to do with where the nodes are anyway.)
+        auto scramble = std::vector<node_id>(generated.node_count);
+        std::iota(scramble.begin(), scramble.end(), 0);
+        std::shuffle(scramble.begin(), scramble.end(), std::default_random_engine {});
+        for(auto &e : generated.edges) {
+            e.start = scramble[e.start];
+            e.end = scramble[e.end];
+        }
+        auto scrambled = freeze<int>(generated);
+        // Every order starts from the same node (the one named 0), so they
+        // all traverse the same part of the graph.
+        auto time = [&](const char *name, const frozen_graph<int> &g) {
+            std::cout << "  " << name << " mean id gap: " << id_spread(g).second << std::endl;
+            report_workspace(name, g, g.id(0), workspace);
+        };
+        auto time_reordering = [&](const char *name, auto &&order) {
+            auto start = benchmark_clock::now();
+            auto reordered = reorder(scrambled, order(scrambled));
+            std::cout << "  " << name << " took "
+                      << std::chrono::duration<double, std::milli>(benchmark_clock::now() - start).count() << " ms"
+                      << std::endl;
+            time(name, reordered);
+        };
+        time("scrambled order", scrambled);
+        time_reordering("bfs_order", [](auto &g) { return bfs_order(g); });
+        time_reordering("rcm_order", [](auto &g) { return rcm_order(g); });
+        time_reordering("gorder", [](auto &g) { return gorder(g); });
+    };
+    auto side = node_id(std::sqrt(double(nodes)));
+    compare("grid", grid_graph(side, side));
+    compare("random geometric", random_geometric_graph(nodes, 8));
+    compare("Erdos-Renyi", erdos_renyi_graph(nodes, 4));
+}
+
+// Weight updates:  the raw cost of update_weights per weight changed (in
+// batches of 1000), and then with cached trees:  repairing the trees from 8
+// sources after each batch of 4 weight changes, against rerunning all 8
+// from scratch, where each batch counts as one step.
+static void benchmark_repair(int nodes) {
+    std::cout << "Weight updates over " << nodes << " nodes" << std::endl;
+    auto g = std::make_shared<frozen_graph<int>>(freeze<int>(erdos_renyi_graph(nodes, 4)));
+    if(g->edge_count() == 0) {
+        std::cout << "  skipped:  no edges to update" << std::endl;
+        return;
+    }
+    auto rng = std::default_random_engine {};
+    auto pick_edge = std::uniform_int_distribution<edge_id>(0, g->edge_count() - 1);
+    // The same range as the generated weights.
+    auto weight = std::uniform_real_distribution<double>(1, 100);
+
+    auto batch = std::vector<weight_change>(1000);
+    for(auto &change : batch) {
+        change = {pick_edge(rng), weight(rng)};
+    }
+    report("frozen_graph::update_weights (per weight)", [&] {
+        g->update_weights(batch);
+        return batch.size();
+    });
+
+    auto sources = std::min(nodes, 8);
+    auto sssp = dynamic_sssp<int>(g);
+    for(auto source = 0; source < sources; ++source) {
+        sssp.add_source(source);
+    }
+    auto changes = std::vector<weight_change>(4);
+    report("dynamic_sssp::update_weights (repair)", [&] {
+        for(auto &change : changes) {
+            change = {pick_edge(rng), weight(rng)};
+        }
+        sssp.update_weights(changes);
+        return size_t(1);
+    });
+    auto workspace = dijkstra_workspace();
+    report("set_weight and rerun every source", [&] {
+        for(size_t k = 0; k < changes.size(); ++k) {
+            g->set_weight(pick_edge(rng), weight(rng));
+        }
+        for(auto source = 0; source < sources; ++source) {
+            workspace.run(*g, g->id(source));
+        }
+        return size_t(1);
+    });
+}
+
+// Bytes a frozen_graph spends on its adjacency:  targets, weights, sources
+// and back-pointers, plus both offset arrays.
+template <class Graph>
+static double frozen_bytes(const Graph &g) {
+    return double(g.edge_count()) * (2 * sizeof(node_id) + sizeof(double) + sizeof(edge_id)) +
+           2.0 * (g.node_count() + 1) * sizeof(edge_id);
+}
+
+static double milliseconds(benchmark_clock::duration elapsed) {
+    return std::chrono::duration<double, std::milli>(elapsed).count();
+}
+
+// The basic measurements on one synthetic graph.
+static void benchmark_generated(const char *kind, int nodes, const std::function<generated_graph()> &generate) {
+    auto start = benchmark_clock::now();
+    auto generated = generate();
+    auto generate_time = benchmark_clock::now() - start;
+    std::cout << kind << ": " << generated.node_count << " nodes, " << generated.edges.size() << " edges"
+              << " (generated in " << milliseconds(generate_time) << " ms)" << std::endl;
+
+    start = benchmark_clock::now();
+    auto frozen = freeze(generated);
+    std::cout << "  frozen_graph build: " << milliseconds(benchmark_clock::now() - start) << " ms, "
+              << frozen_bytes(frozen) / double(frozen.edge_count()) << " bytes/edge" << std::endl;
+    start = benchmark_clock::now();
+    auto compressed = compressed_graph<std::uint64_t>(frozen);
+    std::cout << "  compressed_graph build: " << milliseconds(benchmark_clock::now() - start) << " ms, "
+              << double(compressed.adjacency_bytes()) / double(frozen.edge_count()) << " bytes/edge" << std::endl;
+    if(nodes <= 1000000) {
+        start = benchmark_clock::now();
+        auto g = build_graph(generated);
+        auto built = benchmark_clock::now() - start;
+        auto usage = g->memory_usage();
+        start = benchmark_clock::now();
+        g.reset();
+        std::cout << "  graph<T> build: " << milliseconds(built) << " ms, ~graph: "
+                  << milliseconds(benchmark_clock::now() - start) << " ms, "
+                  << double(usage.total()) / double(generated.edges.size()) << " bytes/edge in use, "
+                  << double(usage.reserved_total()) / double(generated.edges.size()) << " reserved ("
+                  << usage.node_bytes << " nodes, " << usage.edge_bytes << " edges, "
+                  << usage.adjacency_bytes << " adjacency lists, " << usage.hash_table_bytes << " hash table, "
+                  << usage.arena_bytes << " arena)" << std::endl;
+    }
+
+    // Traverse from the node with the most out edges, since on the skewed
+    // kinds node 0 may well have none.
+    node_id hub = 0;
+    for(node_id u = 0; u < frozen.node_count(); ++u) {
+        if(frozen.out_degree(u) > frozen.out_degree(hub)) {
+            hub = u;
+        }
+    }
+    auto workspace = dijkstra_workspace();
+    report_workspace("full traversal (frozen_graph)", frozen, hub, workspace);
+    report_workspace("full traversal (compressed_graph)", compressed, hub, workspace);
+
+    // Point to point queries between random pairs, stopping at the target:
+    // the latency distribution matters more than the mean here.
+    auto rng = std::default_random_engine {};
+    auto pick = std::uniform_int_distribution<node_id>(0, frozen.node_count() - 1);
+    auto latencies = std::vector<double>();
+    auto began = benchmark_clock::now();
+    while(latencies.size() < 10000 && (latencies.size() < 20 || benchmark_clock::now() - began < std::chrono::milliseconds(500))) {
+        auto source = pick(rng);
+        auto target = pick(rng);
+        start = benchmark_clock::now();
+        workspace.run(frozen, source, target);
+        latencies.push_back(std::chrono::duration<double, std::micro>(benchmark_clock::now() - start).count());
+    }
+    std::sort(latencies.begin(), latencies.end());
+    auto mean = std::accumulate(latencies.begin(), latencies.end(), 0.0) / double(latencies.size());
+    std::cout << "  point to point (" << latencies.size() << " queries): mean " << mean
+              << " us, p50 " << latencies[latencies.size() / 2]
+              << " us, p99 " << latencies[latencies.size() * 99 / 100] << " us" << std::endl;
+}
+
+static unsigned log2_ceiling(int nodes) {
+    unsigned scale = 1;
+    while((1 << scale) < nodes) {
+        scale++;
+    }
+    return scale;
+}
+
+// Hop counts on an R-MAT graph (low diameter, like a social network):
+// Dijkstra, which is what a hop count query used to go through, against
+// BFS top-down only and direction optimizing.
+static void benchmark_bfs(int nodes) {
+    auto frozen = freeze(rmat_graph(log2_ceiling(nodes), 16));
+    std::cout << "Hop counts over " << frozen.node_count() << " nodes, " << frozen.edge_count() << " edges" << std::endl;
+    node_id hub = 0;
+    for(node_id u = 0; u < frozen.node_count(); ++u) {
+        if(frozen.out_degree(u) > frozen.out_degree(hub)) {
+            hub = u;
+        }
+    }
+    auto workspace = dijkstra_workspace();
+    report_workspace("dijkstra_workspace", frozen, hub, workspace);
+    auto pool = thread_pool();
+    auto reached = [](const bfs_result &result) {
+        return size_t(std::count_if(result.hops.begin(), result.hops.end(),
+                                    [](std::uint32_t h) { return h != no_hops; }));
+    };
+    auto top_down = [&] {
+        return reached(direction_optimizing_bfs(frozen, hub, pool, 1e-9));
+    };
+    report("direction_optimizing_bfs (top-down only)", top_down);
+    auto stats = traversal_stats();
+    direction_optimizing_bfs(frozen, hub, pool, stats, 1e-9);
+    report_counters("direction_optimizing_bfs (top-down only)", stats.edges_relaxed, top_down);
+    auto levels = std::pair<size_t, size_t>();
+    auto optimizing = [&] {
+        auto result = direction_optimizing_bfs(frozen, hub, pool);
+        levels = {result.bottom_up_levels, result.levels};
+        return reached(result);
+    };
+    report("direction_optimizing_bfs", optimizing);
+    stats.clear();
+    direction_optimizing_bfs(frozen, hub, pool, stats);
+    report_counters("direction_optimizing_bfs", stats.edges_relaxed, optimizing);
+    std::cout << "  (" << levels.first << " of " << levels.second << " levels bottom-up, "
+              << stats.edges_relaxed << " edges looked at)" << std::endl;
+}
+
+// Shortest paths on a DAG (the shape of dependency and pipeline graphs):
+// Dijkstra against relaxing in topological order.
+static void benchmark_dag(int nodes) {
+    // Pointing every edge from the lower numbered node makes a DAG.
+    auto generated = erdos_renyi_graph(nodes, 4);
+    for(auto &e : generated.edges) {
+        if(e.start > e.end) {
+            std::swap(e.start, e.end);
+        }
+    }
+    remove_duplicate_edges(generated.edges);
+    auto frozen = freeze(generated);
+    std::cout << "DAG over " << nodes << " nodes, " << frozen.edge_count() << " edges" << std::endl;
+    auto workspace = dijkstra_workspace();
+    report_workspace("dijkstra_workspace", frozen, 0, workspace);
+    // Both reach the same nodes, so count the same steps for them.
+    auto reached = workspace.settled_count();
+    auto dag = dag_workspace();
+    report("dag_workspace (sort and relax)", [&] {
+        dag.sort(frozen);
+        dag.shortest_paths(frozen, 0);
+        return reached;
+    });
+    auto relax = [&] {
+        dag.shortest_paths(frozen, 0);
+        return reached;
+    };
+    report("dag_workspace (relax only)", relax);
+    auto stats = traversal_stats();
+    dag.shortest_paths(frozen, 0, stats);
+    report_counters("dag_workspace (relax only)", stats.edges_relaxed, relax);
+}
+
+// Point to point queries between random pairs on a sparse R-MAT graph,
+// where most pairs are unreachable:  finding that out with Dijkstra,
+// against asking a reachability_index first.  The steps are queries.
+static void benchmark_reachability(int nodes) {
+    auto frozen = freeze(rmat_graph(log2_ceiling(nodes), 2));
+    auto start = benchmark_clock::now();
+    auto index = reachability_index(frozen);
+    auto built = benchmark_clock::now() - start;
+    std::cout << "Reachability over " << frozen.node_count() << " nodes, " << frozen.edge_count() << " edges:  "
+              << index.components().count << " strong components, built in " << milliseconds(built) << " ms, "
+              << double(index.memory_usage()) / frozen.node_count() << " bytes/node" << std::endl;
+    auto rng = std::mt19937(1);
+    auto pick = std::uniform_int_distribution<node_id>(0, frozen.node_count() - 1);
+    auto pairs = std::vector<std::pair<node_id, node_id>>(200);
+    for(auto &pair : pairs) {
+        pair = {pick(rng), pick(rng)};
+    }
+    auto search = reachability_search();
+    size_t unreachable = 0;
+    for(auto [a, b] : pairs) {
+        unreachable += !index.reaches(a, b, search);
+    }
+    std::cout << "  " << unreachable << " of " << pairs.size() << " pairs unreachable, " << search.search_count()
+              << " needed a search" << std::endl;
+    auto workspace = dijkstra_workspace();
+    report("dijkstra_workspace", [&] {
+        for(auto [a, b] : pairs) {
+            workspace.run(frozen, a, b);
+        }
+        return pairs.size();
+    });
+    report("reachability_index, then dijkstra_workspace", [&] {
+        for(auto [a, b] : pairs) {
+            if(index.reaches(a, b, search)) {
+                workspace.run(frozen, a, b);
+            }
+        }
+        return pairs.size();
+    });
+    // What query_executor does:  the labels only, leaving "maybe" to
+    // Dijkstra.
+    report("reachability_index labels, then dijkstra_workspace", [&] {
+        for(auto [a, b] : pairs) {
+            if(index.might_reach(a, b)) {
+                workspace.run(frozen, a, b);
+            }
+        }
+        return pairs.size();
+    });
+}
+
+// All pairs shortest paths both ways, on graphs from sparse to dense, to
+// see where all_pairs_shortest_paths should switch between them.  The
+// steps are table entries.
+static void benchmark_apsp(int nodes) {
+    auto pool = thread_pool();
+    auto distances = distance_matrix(nodes);
+    for(auto fraction : {0.004, 0.03, 0.1, 0.3}) {
+        auto frozen = freeze(erdos_renyi_graph(nodes, fraction * nodes));
+        std::cout << "All pairs over " << nodes << " nodes, " << frozen.edge_count() << " edges" << std::endl;
+        auto entries = size_t(nodes) * size_t(nodes);
+        report("floyd_warshall", [&] {
+            floyd_warshall(frozen, distances, pool);
+            return entries;
+        });
+        report("repeated_dijkstra", [&] {
+            repeated_dijkstra(frozen, distances, pool);
+            return entries;
+        });
+    }
+}
+
+struct benchmark_case {
+    const char *name;
+    void (*run)(int nodes);
+    int max_nodes;
+};
+
+static const benchmark_case benchmark_cases[] = {
+    {"loading", benchmark_loading, 1000000},
+    {"traversals", benchmark_traversals, 20000},
+    {"compression", benchmark_compression, 1000000},
+    {"reordering", benchmark_reordering, 1000000},
+    {"repair", benchmark_repair, 1000000},
+    {"bfs", benchmark_bfs, 100000000},
+    {"dag", benchmark_dag, 100000000},
+    {"reachability", benchmark_reachability, 1000000},
+    {"apsp", benchmark_apsp, 2000},
+    {"generators/rmat", [](int nodes) {
+        benchmark_generated("R-MAT", nodes, [&] { return rmat_graph(log2_ceiling(nodes), 8); });
+    }, 100000000},
+    {"generators/grid", [](int nodes) {
+        auto side = node_id(std::sqrt(double(nodes)));
+        benchmark_generated("grid", nodes, [&] { return grid_graph(side, side); });
+    }, 100000000},
+    {"generators/geometric", [](int nodes) {
+        benchmark_generated("random geometric", nodes, [&] { return random_geometric_graph(nodes, 8); });
+    }, 100000000},
+    {"generators/erdos_renyi", [](int nodes) {
+        benchmark_generated("Erdos-Renyi", nodes, [&] { return erdos_renyi_graph(nodes, 8); });
+    }, 100000000},
+    {"generators/power_law", [](int nodes) {
+        benchmark_generated("power law", nodes, [&] { return power_law_graph(nodes, 8, 2.5); });
+    }, 100000000},
+};
+
+static int largest_case() {
+    auto largest = 0;
+    for(auto &bench : benchmark_cases) {
+        largest = std::max(largest, bench.max_nodes);
+    }
+    return largest;
+}
+
+static int usage(const char *program) {
+    std::cerr << "Usage: " << program << " [--filter=text] [nodes...]" << std::endl;
+    std::cerr << "  where each size of graph is from 1 to " << largest_case() << " nodes (1e6 and the like are fine)"
+              << std::endl;
+    return 2;
+}
+
+int main(int argc, char **argv) {
+    auto sizes = std::vector<int>();
+    auto filter = std::string();
+    for(auto i = 1; i < argc; ++i) {
+        auto argument = std::string(argv[i]);
+        if(argument.starts_with("--filter=")) {
+            filter = argument.substr(9);
+            continue;
+        }
+        if(argument.starts_with("--")) {
+            return usage(argv[0]);
+        }
+        // Check the whole argument is a number, and bound it before
+        // converting, since a double past INT_MAX doesn't fit an int.
+        char *end = nullptr;
+        auto nodes = std::strtod(argv[i], &end);
+        if(end == argv[i] || *end != '\0' || !(nodes >= 1) || nodes > largest_case()) {
+            return usage(argv[0]);
+        }
+        sizes.push_back(int(nodes));
+    }
+    if(sizes.empty()) {
+        sizes = {1000, 10000, 100000};
+    }
+    if(!counters.any_available()) {
+        std::cout << "(hardware counters unavailable:  wall time only)" << std::endl;
+    }
+    for(auto nodes : sizes) {
+        for(auto &bench : benchmark_cases) {
+            if(std::string(bench.name).find(filter) == std::string::npos) {
+                continue;
+            }
+            std::cout << "[" << bench.name << " " << nodes << "]" << std::endl;
+            if(nodes > bench.max_nodes) {
+                std::cout << "  skipped:  only run up to " << bench.max_nodes << " nodes" << std::endl;
+                continue;
+            }
+            bench.run(nodes);
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,172 @@
+#include "bfs.hpp"
+
+#include <cassert>
+#include <iostream>
+
+#include "compressed_graph.hpp"
+#include "graph_generators.hpp"
+#include "reference_search.hpp"
+
+// Checks both BFS versions against the simplest possible BFS:  the same hop
+// counts, and parents that really are one hop closer along a real edge.
+// The R-MAT graph is the low diameter kind the bottom-up steps are for, so
+// the direction switching gets exercised there.
+
+static_assert(std::input_iterator<bfs_traversal_iterator<int>>);
+static_assert(std::ranges::view<bfs_traversal<int>>);
+
+template <class Graph>
+static void check(const Graph &g, node_id source, const bfs_result &result) {
+    auto expected = reference_hops(g, source);
+    assert(result.hops == expected);
+    std::uint32_t deepest = 0;
+    for(node_id v = 0; v < g.node_count(); ++v) {
+        auto p = result.parent[v];
+        if(v == source || result.hops[v] == no_hops) {
+            assert(p == no_node);
+            continue;
+        }
+        deepest = std::max(deepest, result.hops[v]);
+        assert(result.hops[p] + 1 == result.hops[v]);
+        auto found = false;
+        g.for_each_out_edge(p, [&](node_id next, double) { found = found || next == v; });
+        assert(found);
+    }
+    assert(result.levels == deepest + 1);
+}
+
+void testBfs() {
+    std::cerr << "Initializing BFS tests" << std::endl;
+    auto pool = thread_pool(4);
+    auto serial = thread_pool(1);
+
+    auto rmat = freeze(rmat_graph(12, 8));
+    node_id hub = 0;
+    for(node_id u = 0; u < rmat.node_count(); ++u) {
+        if(rmat.out_degree(u) > rmat.out_degree(hub)) {
+            hub = u;
+        }
+    }
+    auto result = direction_optimizing_bfs(rmat, hub, pool);
+    check(rmat, hub, result);
+    assert(result.bottom_up_levels > 0 && result.bottom_up_levels < result.levels);
+    check(rmat, hub, direction_optimizing_bfs(rmat, hub, serial));
+    // Never switching, and always switching, still give the same answer.
+    result = direction_optimizing_bfs(rmat, hub, pool, 1e-9);
+    check(rmat, hub, result);
+    assert(result.bottom_up_levels == 0);
+    result = direction_optimizing_bfs(rmat, hub, pool, HUGE_VAL, HUGE_VAL);
+    check(rmat, hub, result);
+    assert(result.bottom_up_levels == result.levels);
+    // Graphs without in_neighbors() go through for_each_in_edge.
+    auto compressed = compressed_graph<std::uint64_t>(rmat);
+    check(compressed, hub, direction_optimizing_bfs(compressed, hub, pool));
+    for(node_id source = 0; source < 20; ++source) {
+        check(rmat, source, direction_optimizing_bfs(rmat, source, pool));
+    }
+
+    // Counting:  every reached node settled once, through the queue once,
+    // and top-down, every edge out of a reached node looked at once.
+    // Bottom-up looks at in edges instead, and only until it finds one.
+    auto reached = size_t(0);
+    auto out_of_reached = size_t(0);
+    for(node_id u = 0; u < rmat.node_count(); ++u) {
+        if(result.hops[u] != no_hops) {
+            reached++;
+            out_of_reached += rmat.out_degree(u);
+        }
+    }
+    auto stats = traversal_stats();
+    check(rmat, hub, direction_optimizing_bfs(rmat, hub, pool, stats, 1e-9));
+    assert(stats.nodes_settled == reached && stats.queue_pushes == reached && stats.queue_pops == reached);
+    assert(stats.edges_relaxed == out_of_reached && stats.decrease_keys == 0);
+    assert(stats.peak_frontier > 1 && stats.peak_frontier < reached);
+    stats.clear();
+    check(rmat, hub, direction_optimizing_bfs(rmat, hub, pool, stats));
+    assert(stats.nodes_settled == reached && stats.queue_pops == reached);
+    assert(stats.edges_relaxed > 0 && stats.edges_relaxed < out_of_reached);
+
+    auto grid = freeze(grid_graph(40, 50));
+    check(grid, 0, direction_optimizing_bfs(grid, 0, pool));
+    check(grid, 1234, direction_optimizing_bfs(grid, 1234, serial));
+
+    // Two dense clusters, a big one and then a smaller one down a long
+    // path.  The switch test only sees the smaller one's frontier as big
+    // enough for bottom-up if the big one's edges were taken off the count
+    // after it was done, including those of the nodes bottom-up woke.
+    auto clusters = generated_graph {1210, {}};
+    auto link = [&](node_id a, node_id b) {
+        clusters.edges.push_back({a, b, 1});
+        clusters.edges.push_back({b, a, 1});
+    };
+    auto cluster = [&](node_id first, node_id size) {
+        for(node_id i = 1; i < size; ++i) {
+            link(first, first + i);
+            for(node_id k = 1; k <= 20; ++k) {
+                link(first + i, first + 1 + (i - 1 + k) % (size - 1));
+            }
+        }
+    };
+    cluster(0, 1000);
+    for(node_id u = 999; u < 1010; ++u) {
+        link(u, u + 1);
+    }
+    cluster(1010, 200);
+    remove_duplicate_edges(clusters.edges);
+    auto two_phase = freeze(clusters);
+    result = direction_optimizing_bfs(two_phase, 0, pool, 2);
+    check(two_phase, 0, result);
+    assert(result.hops[1011] == 13 && result.bottom_up_levels >= 2);
+
+    // The lazy version over a graph<T>:  every reachable node once, in
+    // order of hop count, each reached from a node one hop closer.
+    auto generated = rmat_graph(9, 4);
+    auto g = build_graph(generated);
+    auto frozen = freeze(generated);
+    for(node_id source : {0u, 1u, 100u}) {
+        auto expected = reference_hops(frozen, source);
+        size_t count = 0;
+        size_t last = 0;
+        for(auto &step : bfs_traversal<std::uint64_t>(g, source)) {
+            assert(step.hops == expected[step.current->name]);
+            assert(step.hops >= last);
+            last = step.hops;
+            if(step.previous == nullptr) {
+                assert(step.current->name == source && step.hops == 0);
+            } else {
+                assert(expected[step.previous->name] + 1 == step.hops);
+            }
+            count++;
+        }
+        assert(count == size_t(std::count_if(expected.begin(), expected.end(),
+                                             [](std::uint32_t h) { return h != no_hops; })));
+    }
+    // And counting the lazy version.
+    auto stats_of_lazy = traversal_stats();
+    auto steps = size_t(0);
+    for([[maybe_unused]] auto &step : bfs_traversal<std::uint64_t, true>(g, 0, stats_of_lazy)) {
+        steps++;
+    }
+    auto lazy_edges = size_t(0);
+    auto expected = reference_hops(frozen, 0);
+    for(node_id u = 0; u < frozen.node_count(); ++u) {
+        lazy_edges += expected[u] != no_hops ? frozen.out_degree(u) : 0;
+    }
+    assert(stats_of_lazy.nodes_settled == steps && stats_of_lazy.queue_pushes == steps);
+    assert(stats_of_lazy.queue_pops == steps && stats_of_lazy.edges_relaxed == lazy_edges);
+    // Stopping early with the std::views adaptors.
+    size_t near = 0;
+    for([[maybe_unused]] auto &step : bfs_traversal<std::uint64_t>(g, 0)
+                                      | std::views::take_while([](auto &s) { return s.hops <= 1; })) {
+        near++;
+    }
+    assert(near == frozen.out_degree(0) + 1);
+
+    auto threw = false;
+    try {
+        direction_optimizing_bfs(grid, grid.node_count(), pool);
+    } catch(std::logic_error &) {
+        threw = true;
+    }
+    assert(threw);
+}
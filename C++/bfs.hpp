@@ -0,0 +1,416 @@
+#ifndef BFS_H
+#define BFS_H
+
+#include <atomic>
+#include <bit>
+#include <cstdint>
+#include <limits>
+#include <memory_resource>
+#include <unordered_set>
+#include <vector>
+
+#include "frozen_graph.hpp"
+#include "graph.hpp"
+#include "thread_pool.hpp"
+#include "traversal_stats.hpp"
+
+// Breadth first search, for the queries that only care about hop counts.
+//
+// Dijkstra does a lot of work a hop count doesn't need:  a priority queue
+// instead of a plain FIFO, and floating point distances.  So there are two
+// BFS versions here.
+//
+// bfs_traversal is the lazy one, in the same style as dijkstra_traversal:
+// a range over a graph<T> that hands out one step at a time, in order of
+// hop count, so a query can stop as soon as it has what it wants.
+//
+// direction_optimizing_bfs is the bulk one, for whole graph hop counts over
+// the dense graph types (frozen_graph and friends), after Beamer, Asanovic
+// and Patterson, "Direction-Optimizing Breadth-First Search" (SC 2012).
+// The ordinary "top-down" step looks at every edge out of the frontier to
+// find the unvisited nodes.  On a low diameter graph (a social network,
+// say) the frontier soon covers a big fraction of the graph, and then most
+// of those edges lead to nodes that are already visited.  So once the
+// frontier gets big the search switches to "bottom-up" steps instead, where
+// every unvisited node looks through its in edges for any node in the
+// frontier, and stops at the first one:  since most unvisited nodes by then
+// have a neighbour in the frontier, most stop almost immediately.  Once the
+// frontier shrinks again it switches back.
+//
+// The bottom-up step needs to test "is this node in the frontier" fast, so
+// there the frontier is a bitmap;  the top-down step wants to walk just
+// the frontier, so there it is a list of nodes.  Each step is a parallel
+// loop on the thread pool.
+//
+// Both fill in a traversal_stats when asked to, like dijkstra_traversal
+// and dijkstra_workspace (bfs_traversal<T, true>, or direction_optimizing_bfs
+// given one).  A BFS has no priority queue, so there are never any
+// decrease-keys;  the "queue" is the FIFO for bfs_traversal and the current
+// and next levels for direction_optimizing_bfs, and an edge counts as
+// relaxed whenever it is looked at, top-down or bottom-up.
+
+// One step of a bfs_traversal:  the node reached, how many hops from the
+// start it is, and the node it was reached from (null for the start).
+template <class T>
+struct bfs_step {
+    std::shared_ptr<graph_node<T>> current;
+    size_t hops = 0;
+    std::shared_ptr<graph_node<T>> previous = nullptr;
+};
+
+template <class T, bool Instrumented = false> class bfs_traversal;
+
+template <class T, bool Instrumented>
+class bfs_traversal_iterator {
+    friend bfs_traversal<T, Instrumented>;
+public:
+    using iterator_concept = std::input_iterator_tag;
+    using value_type = bfs_step<T>;
+    using difference_type = std::ptrdiff_t;
+
+private:
+    std::shared_ptr<const graph<T>> working_graph = nullptr;
+    // The FIFO is a vector read from head onwards, rather than a deque:  a
+    // traversal only ever adds each node once, so nothing is gained by
+    // giving back the space of the ones already handed out.
+    std::pmr::vector<bfs_step<T>> queue;
+    size_t head = 0;
+    std::pmr::unordered_set<const graph_node<T> *> seen;
+    [[no_unique_address]] traversal_recorder<Instrumented> recorder;
+
+    bfs_traversal_iterator(std::shared_ptr<const graph<T>> graph_ptr, T start,
+                           traversal_recorder<Instrumented> recorderIn, std::pmr::memory_resource *resource) :
+    working_graph(graph_ptr), queue(resource), seen(resource), recorder(recorderIn) {
+        auto itr = working_graph->nodes.find(start);
+        if(itr == working_graph->nodes.end()) {
+            throw std::logic_error("Unable to find the node");
+        }
+        auto started = recorder.now();
+        seen.insert(itr->second.get());
+        queue.push_back({itr->second, 0, nullptr});
+        recorder.pushed();
+        recorder.add_setup_time(started);
+        handed_out();
+    }
+
+    // The node at head is the next step:  its hop count is final.
+    void handed_out() {
+        if(head < queue.size()) {
+            recorder.popped();
+            recorder.settled();
+        }
+    }
+
+    // Moves past the current node, queueing every node it leads to that
+    // hasn't been seen before.
+    void iter() {
+        auto started = recorder.now();
+        // Copied out, since pushing onto the queue can move the step.
+        auto current = queue[head].current;
+        auto hops = queue[head].hops;
+        head++;
+        for (auto &edge : current->out_edges) {
+            recorder.relaxed();
+            if(seen.insert(edge->end.get()).second) {
+                queue.push_back({edge->end, hops + 1, current});
+                recorder.pushed();
+            }
+        }
+        handed_out();
+        recorder.add_search_time(started);
+    }
+
+public:
+    bfs_traversal_iterator() = default;
+
+    bfs_traversal_iterator &operator++() {
+        iter();
+        return *this;
+    }
+
+    void operator++(int) {
+        iter();
+    }
+
+    const bfs_step<T> &operator*() const {
+        return queue[head];
+    }
+
+    bool operator==(dijkstra_traversal_sentinel) const {
+        return head == queue.size();
+    }
+};
+
+template <class T, bool Instrumented>
+class bfs_traversal : public std::ranges::view_interface<bfs_traversal<T, Instrumented>> {
+public:
+    std::shared_ptr<const graph<T>> working_graph;
+    T start;
+    [[no_unique_address]] traversal_recorder<Instrumented> recorder;
+    std::pmr::memory_resource *resource;
+
+    bfs_traversal(std::shared_ptr<const graph<T>> g, T s,
+                  std::pmr::memory_resource *resourceIn = std::pmr::get_default_resource())
+    requires (!Instrumented) : working_graph(g), start(s), resource(resourceIn) {
+    }
+
+    bfs_traversal(std::shared_ptr<const graph<T>> g, T s, traversal_stats &stats,
+                  std::pmr::memory_resource *resourceIn = std::pmr::get_default_resource())
+    requires Instrumented : working_graph(g), start(s), recorder(stats), resource(resourceIn) {
+    }
+
+    bfs_traversal_iterator<T, Instrumented> begin() const {
+        return bfs_traversal_iterator<T, Instrumented>(working_graph, start, recorder, resource);
+    }
+
+    dijkstra_traversal_sentinel end() const {
+        return {};
+    }
+};
+
+constexpr std::uint32_t no_hops = std::numeric_limits<std::uint32_t>::max();
+
+struct bfs_result {
+    // Hops from the source, or no_hops if unreachable.
+    std::vector<std::uint32_t> hops;
+    // A node one hop closer to the source, or no_node for the source and
+    // for unreachable nodes.  When there are several the choice depends on
+    // how the threads interleave.
+    std::vector<node_id> parent;
+    // How many steps the search took (one more than the largest hop count),
+    // and how many of those were done bottom-up.
+    size_t levels = 0;
+    size_t bottom_up_levels = 0;
+};
+
+// A set of nodes, one bit each.
+class node_bitmap {
+private:
+    std::vector<std::uint64_t> words;
+
+public:
+    explicit node_bitmap(size_t n) : words((n + 63) / 64, 0) {
+    }
+
+    size_t word_count() const {
+        return words.size();
+    }
+
+    bool test(node_id u) const {
+        return (words[u / 64] >> (u % 64)) & 1;
+    }
+
+    void set(node_id u) {
+        words[u / 64] |= std::uint64_t(1) << (u % 64);
+    }
+
+    std::uint64_t &word(size_t w) {
+        return words[w];
+    }
+
+    void clear() {
+        std::fill(words.begin(), words.end(), 0);
+    }
+
+    void swap(node_bitmap &other) {
+        words.swap(other.words);
+    }
+
+    // Calls f(u) for every node in the set, in order.
+    template <class F>
+    void for_each(F &&f) const {
+        for(size_t w = 0; w < words.size(); ++w) {
+            for(auto bits = words[w]; bits != 0; bits &= bits - 1) {
+                f(node_id(w * 64 + std::countr_zero(bits)));
+            }
+        }
+    }
+};
+
+template <class Graph>
+size_t bfs_out_degree(const Graph &g, node_id u) {
+    if constexpr (requires { g.out_degree(u); }) {
+        return g.out_degree(u);
+    } else {
+        size_t degree = 0;
+        g.for_each_out_edge(u, [&](node_id, double) { degree++; });
+        return degree;
+    }
+}
+
+// Beamer's switching thresholds:  go bottom-up once the edges out of the
+// frontier are more than 1/alpha of the edges out of the unvisited nodes,
+// and back top-down once the frontier is both shrinking and under 1/beta
+// of the nodes.  alpha = 15 and beta = 18 are the paper's values.
+template <class Graph, bool Instrumented>
+bfs_result direction_optimizing_search(const Graph &g, node_id source, thread_pool &pool, double alpha, double beta,
+                                       traversal_recorder<Instrumented> recorder) {
+    auto n = g.node_count();
+    if(source >= n) {
+        throw std::logic_error("Unable to find the node");
+    }
+    auto started = recorder.now();
+    auto result = bfs_result();
+    result.hops.assign(n, no_hops);
+    result.parent.assign(n, no_node);
+    auto &hops = result.hops;
+    auto &parent = result.parent;
+    hops[source] = 0;
+
+    size_t edges_to_check = 0;
+    for(node_id u = 0; u < n; ++u) {
+        edges_to_check += bfs_out_degree(g, u);
+    }
+    auto frontier = std::vector<node_id> {source};
+    auto next = std::vector<std::vector<node_id>>(pool.size());
+    auto scouts = std::vector<size_t>(pool.size());
+    auto awake = std::vector<size_t>(pool.size());
+    auto front_bits = node_bitmap(n);
+    auto next_bits = node_bitmap(n);
+    size_t scout_count = bfs_out_degree(g, source);
+    std::uint32_t level = 0;
+    // Edges each worker looked at, when counting:  the workers can't share
+    // the recorder, so their counts are added to it after each level.
+    auto examined = std::vector<size_t>(Instrumented ? pool.size() : 0);
+    auto add_examined = [&] {
+        if constexpr (Instrumented) {
+            for(auto &count : examined) {
+                recorder.relaxed(count);
+                count = 0;
+            }
+        }
+    };
+    recorder.pushed();
+    recorder.add_setup_time(started);
+    started = recorder.now();
+
+    while(!frontier.empty()) {
+        if(double(scout_count) > double(edges_to_check) / alpha) {
+            // Bottom-up, until the frontier is small and shrinking.
+            front_bits.clear();
+            for(auto u : frontier) {
+                front_bits.set(u);
+            }
+            size_t awake_count = frontier.size();
+            size_t old_awake;
+            do {
+                old_awake = awake_count;
+                recorder.popped(old_awake);
+                recorder.settled(old_awake);
+                // As top-down does, this level's frontier leaves the edges
+                // still to check, and the nodes it wakes make the next
+                // frontier's scout count.
+                edges_to_check -= std::min(edges_to_check, scout_count);
+                std::fill(awake.begin(), awake.end(), 0);
+                std::fill(scouts.begin(), scouts.end(), 0);
+                // Each task owns 64 nodes (one word of next_bits), so no
+                // two threads ever write the same hop count or word.
+                pool.parallel_for(front_bits.word_count(), [&](unsigned worker, size_t w) {
+                    std::uint64_t found = 0;
+                    auto end = std::min<size_t>(n, (w + 1) * 64);
+                    for(auto v = node_id(w * 64); v < end; ++v) {
+                        if(hops[v] != no_hops) {
+                            continue;
+                        }
+                        auto adopt = [&](node_id u) {
+                            hops[v] = level + 1;
+                            parent[v] = u;
+                            found |= std::uint64_t(1) << (v % 64);
+                            awake[worker]++;
+                            scouts[worker] += bfs_out_degree(g, v);
+                        };
+                        if constexpr (requires { g.in_neighbors(v); }) {
+                            for(auto u : g.in_neighbors(v)) {
+                                if constexpr (Instrumented) {
+                                    examined[worker]++;
+                                }
+                                if(front_bits.test(u)) {
+                                    adopt(u);
+                                    break;
+                                }
+                            }
+                        } else {
+                            g.for_each_in_edge(v, [&](node_id u, double) {
+                                if constexpr (Instrumented) {
+                                    examined[worker] += hops[v] == no_hops;
+                                }
+                                if(hops[v] == no_hops && front_bits.test(u)) {
+                                    adopt(u);
+                                }
+                            });
+                        }
+                    }
+                    next_bits.word(w) = found;
+                }, 16);
+                front_bits.swap(next_bits);
+                awake_count = 0;
+                scout_count = 0;
+                for(unsigned w = 0; w < pool.size(); ++w) {
+                    awake_count += awake[w];
+                    scout_count += scouts[w];
+                }
+                recorder.pushed(awake_count);
+                add_examined();
+                level++;
+                result.levels++;
+                result.bottom_up_levels++;
+            } while(awake_count > 0 && (awake_count >= old_awake || double(awake_count) > double(n) / beta));
+            frontier.clear();
+            front_bits.for_each([&](node_id u) { frontier.push_back(u); });
+            continue;
+        }
+
+        // Top-down:  claim each unvisited node by swapping its hop count
+        // from no_hops, so exactly one thread gets to set its parent.
+        recorder.popped(frontier.size());
+        recorder.settled(frontier.size());
+        std::fill(scouts.begin(), scouts.end(), 0);
+        pool.parallel_for(frontier.size(), [&](unsigned worker, size_t i) {
+            auto u = frontier[i];
+            g.for_each_out_edge(u, [&](node_id v, double) {
+                if constexpr (Instrumented) {
+                    examined[worker]++;
+                }
+                auto claim = std::atomic_ref<std::uint32_t>(hops[v]);
+                auto expected = no_hops;
+                if(claim.load(std::memory_order_relaxed) == no_hops &&
+                   claim.compare_exchange_strong(expected, level + 1, std::memory_order_relaxed)) {
+                    parent[v] = u;
+                    next[worker].push_back(v);
+                    scouts[worker] += bfs_out_degree(g, v);
+                }
+            });
+        });
+        edges_to_check -= std::min(edges_to_check, scout_count);
+        frontier.clear();
+        scout_count = 0;
+        for(unsigned w = 0; w < pool.size(); ++w) {
+            frontier.insert(frontier.end(), next[w].begin(), next[w].end());
+            next[w].clear();
+            scout_count += scouts[w];
+        }
+        recorder.pushed(frontier.size());
+        add_examined();
+        level++;
+        result.levels++;
+    }
+    recorder.add_search_time(started);
+    return result;
+}
+
+template <class Graph>
+bfs_result direction_optimizing_bfs(const Graph &g, node_id source, thread_pool &pool,
+                                    double alpha = 15, double beta = 18) {
+    return direction_optimizing_search(g, source, pool, alpha, beta, traversal_recorder<false>());
+}
+
+// The same, adding what the search did to stats.
+template <class Graph>
+bfs_result direction_optimizing_bfs(const Graph &g, node_id source, thread_pool &pool, traversal_stats &stats,
+                                    double alpha = 15, double beta = 18) {
+    return direction_optimizing_search(g, source, pool, alpha, beta, traversal_recorder<true>(stats));
+}
+
+void testBfs();
+
+#endif //BFS_H
@@ -0,0 +1,196 @@
+#include "binary_graph.hpp"
+
+#include <array>
+#include <cassert>
+#include <cstddef>
+#include <filesystem>
+
+#include "dijkstra_workspace.hpp"
+#include "graph_generators.hpp"
+
+// Writes frozen graphs out (with int names and with string names), maps
+// them back in, and checks that the mapped graph has exactly the same
+// names, ids and edges, and gives the same shortest paths.  Then checks
+// that files that aren't graph files are turned away.
+
+template <class T, class Name>
+static void check_round_trip(const std::string &path, Name &&make_name) {
+    const int count = 200;
+    auto g = build_graph<T>(erdos_renyi_graph(count, 4), make_name);
+    auto frozen = frozen_graph<T>(*g);
+    write_binary_graph(frozen, path);
+    auto mapped = mapped_graph<T>(path);
+
+    assert(mapped.node_count() == frozen.node_count());
+    assert(mapped.edge_count() == frozen.edge_count());
+    for(node_id u = 0; u < frozen.node_count(); ++u) {
+        assert(mapped.name(u) == frozen.name(u));
+        assert(mapped.id(frozen.name(u)) == u);
+        assert(std::ranges::equal(mapped.out_neighbors(u), frozen.out_neighbors(u)));
+        assert(std::ranges::equal(mapped.in_neighbors(u), frozen.in_neighbors(u)));
+        auto weights = std::vector<double>();
+        frozen.for_each_in_edge(u, [&](node_id, double w) { weights.push_back(w); });
+        size_t k = 0;
+        mapped.for_each_in_edge(u, [&](node_id, double w) { assert(w == weights[k++]); });
+        assert(k == weights.size());
+    }
+    assert(!mapped.contains(make_name(count)));
+
+    auto expected = dijkstra_workspace();
+    auto actual = dijkstra_workspace();
+    for(auto source = 0; source < 5; ++source) {
+        expected.run(frozen, frozen.id(make_name(source)));
+        actual.run(mapped, mapped.id(make_name(source)));
+        for(node_id u = 0; u < frozen.node_count(); ++u) {
+            assert(expected.distance(u) == actual.distance(u));
+            assert(expected.parent(u) == actual.parent(u));
+        }
+    }
+}
+
+// Copies the graph file at from to to, with the value at position
+// overwritten, and says whether opening the copy is turned away.
+template <class T, class U>
+static bool rejects_corrupt(const std::string &from, const std::string &to, size_t position, U value) {
+    std::filesystem::copy_file(from, to, std::filesystem::copy_options::overwrite_existing);
+    {
+        auto out = std::fstream(to, std::ios::binary | std::ios::in | std::ios::out);
+        out.seekp(std::streamoff(position));
+        out.write(reinterpret_cast<const char *>(&value), sizeof(value));
+    }
+    try {
+        mapped_graph<T> g(to);
+    } catch(std::domain_error &) {
+        return true;
+    }
+    return false;
+}
+
+// Where element index of section s starts in the graph file at path.
+template <class U>
+static size_t element_position(const std::string &path, binary_graph_section s, size_t index) {
+    auto header = binary_graph_header {};
+    auto in = std::ifstream(path, std::ios::binary);
+    in.read(reinterpret_cast<char *>(&header), sizeof(header));
+    return size_t(header.sections[size_t(s)].offset) + index * sizeof(U);
+}
+
+// Files whose header passes but whose counts, offsets or ids would send
+// the accessors outside the mapping.
+static void check_corrupt_files(const std::string &directory) {
+    auto int_path = directory + "/graph_test_corrupt_int.bin";
+    auto string_path = directory + "/graph_test_corrupt_string.bin";
+    auto bad_path = directory + "/graph_test_corrupt.bin";
+    auto g = graph<int>();
+    auto h = graph<std::string>();
+    for(auto i = 0; i < 4; ++i) {
+        g.create_node(i);
+        h.create_node("node " + std::to_string(i));
+    }
+    for(auto i = 0; i < 3; ++i) {
+        g.create_link(i, i + 1, 1.0);
+        h.create_link("node " + std::to_string(i), "node " + std::to_string(i + 1), 1.0);
+    }
+    write_binary_graph(frozen_graph<int>(g), int_path);
+    write_binary_graph(frozen_graph<std::string>(h), string_path);
+    {
+        mapped_graph<int> unchanged(int_path);
+        mapped_graph<std::string> also_unchanged(string_path);
+    }
+
+    // An edge count so large that count * sizeof(node_id) wraps to 0.
+    auto edge_count = offsetof(binary_graph_header, edge_count);
+    assert(rejects_corrupt<int>(int_path, bad_path, edge_count, std::uint64_t(1) << 62));
+    // Offsets that go down, or past the edge count.
+    auto out_offsets = binary_graph_section::out_offsets;
+    assert(rejects_corrupt<int>(int_path, bad_path, element_position<edge_id>(int_path, out_offsets, 1),
+                                edge_id(3)));
+    assert(rejects_corrupt<int>(int_path, bad_path, element_position<edge_id>(int_path, out_offsets, 0),
+                                edge_id(1)));
+    auto in_offsets = binary_graph_section::in_offsets;
+    assert(rejects_corrupt<int>(int_path, bad_path, element_position<edge_id>(int_path, in_offsets, 2),
+                                edge_id(1000)));
+    // Node and edge ids past the end.
+    auto out_targets = binary_graph_section::out_targets;
+    assert(rejects_corrupt<int>(int_path, bad_path, element_position<node_id>(int_path, out_targets, 0),
+                                node_id(4)));
+    auto in_sources = binary_graph_section::in_sources;
+    assert(rejects_corrupt<int>(int_path, bad_path, element_position<node_id>(int_path, in_sources, 2),
+                                no_node - 1));
+    auto in_edges = binary_graph_section::in_edges;
+    assert(rejects_corrupt<int>(int_path, bad_path, element_position<edge_id>(int_path, in_edges, 1),
+                                edge_id(3)));
+    auto name_order = binary_graph_section::name_order;
+    assert(rejects_corrupt<int>(int_path, bad_path, element_position<node_id>(int_path, name_order, 3),
+                                node_id(17)));
+    // A name order with two entries swapped, or one repeated, which would
+    // send the binary search the wrong way.
+    auto order_pair = [&](const std::string &path) {
+        auto pair = std::array<node_id, 2>();
+        auto in = std::ifstream(path, std::ios::binary);
+        in.seekg(std::streamoff(element_position<node_id>(path, name_order, 1)));
+        in.read(reinterpret_cast<char *>(pair.data()), sizeof(pair));
+        return pair;
+    };
+    auto [first, second] = order_pair(int_path);
+    assert(rejects_corrupt<int>(int_path, bad_path, element_position<node_id>(int_path, name_order, 1),
+                                std::array<node_id, 2> {second, first}));
+    assert(rejects_corrupt<int>(int_path, bad_path, element_position<node_id>(int_path, name_order, 2), first));
+    auto [first_string, second_string] = order_pair(string_path);
+    assert(rejects_corrupt<std::string>(string_path, bad_path,
+                                        element_position<node_id>(string_path, name_order, 1),
+                                        std::array<node_id, 2> {second_string, first_string}));
+    // A name that starts after the next one, or runs past the characters.
+    auto names = binary_graph_section::names;
+    assert(rejects_corrupt<std::string>(string_path, bad_path,
+                                        element_position<std::uint64_t>(string_path, names, 2),
+                                        std::uint64_t(30)));
+    assert(rejects_corrupt<std::string>(string_path, bad_path,
+                                        element_position<std::uint64_t>(string_path, names, 0),
+                                        std::uint64_t(1)));
+
+    std::filesystem::remove(int_path);
+    std::filesystem::remove(string_path);
+    std::filesystem::remove(bad_path);
+}
+
+void testBinaryGraph() {
+    std::cerr << "Initializing binary graph tests" << std::endl;
+    auto directory = std::filesystem::temp_directory_path();
+    auto int_path = (directory / "graph_test_int.bin").string();
+    auto string_path = (directory / "graph_test_string.bin").string();
+
+    check_round_trip<int>(int_path, [](int i) { return i * 7; });
+    check_round_trip<std::string>(string_path, [](int i) { return "node " + std::to_string(i); });
+
+    // The wrong name type, a file that isn't a graph, and a truncated file.
+    auto rejected = [](auto &&open) {
+        try {
+            open();
+        } catch(std::domain_error &) {
+            return true;
+        }
+        return false;
+    };
+    assert(rejected([&] { mapped_graph<std::string> g(int_path); }));
+    {
+        auto out = std::ofstream(string_path, std::ios::binary | std::ios::trunc);
+        out << std::string(1024, 'x');
+    }
+    assert(rejected([&] { mapped_graph<std::string> g(string_path); }));
+    std::filesystem::resize_file(int_path, 256);
+    assert(rejected([&] { mapped_graph<int> g(int_path); }));
+
+    auto missing = false;
+    try {
+        mapped_graph<int> g((directory / "graph_test_missing.bin").string());
+    } catch(std::system_error &) {
+        missing = true;
+    }
+    assert(missing);
+
+    check_corrupt_files(directory.string());
+
+    std::filesystem::remove(int_path);
+    std::filesystem::remove(string_path);
+}
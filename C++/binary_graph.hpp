@@ -0,0 +1,407 @@
+#ifndef BINARY_GRAPH_H
+#define BINARY_GRAPH_H
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <type_traits>
+
+#include "frozen_graph.hpp"
+#include "mapped_file.hpp"
+
+// A binary file format for frozen graphs, designed so that loading one is
+// just mapping the file into memory.
+//
+// Rebuilding a big graph from text means millions of create_node and
+// create_link calls, each allocating and hashing.  But a frozen_graph is
+// just a handful of flat arrays, so if those arrays are written to disk
+// exactly as they sit in memory, "loading" the graph is simply mmap()ing
+// the file:  the operating system maps the file's pages straight into our
+// address space, nothing is parsed or copied, and pages are only read off
+// the disk the first time something touches them (and if the file is
+// already in the page cache, not even then).
+//
+// The file is a header followed by a series of sections, each starting on
+// a 64 byte boundary (so every array is aligned to a cache line):
+//
+//   names        the node names, in id order
+//   name_chars   (string names only) the characters of all the names
+//   name_order   node ids sorted by name, for looking names up
+//   out_offsets, out_targets, out_weights     the forward CSR
+//   in_offsets, in_sources, in_edges          the reverse CSR
+//
+// Names can be any trivially copyable type (ints and the like), stored
+// as-is, or std::string, in which case the names section holds each name's
+// starting offset into name_chars.  Looking a name up is a binary search
+// over name_order, so names need a < operator.
+//
+// The numbers are stored in the machine's native byte order, and the
+// header records that order so that a file from a machine with the other
+// order is rejected rather than misread.
+
+constexpr std::uint32_t binary_graph_version = 1;
+constexpr size_t binary_graph_alignment = 64;
+
+enum class binary_graph_section : std::uint32_t {
+    names, name_chars, name_order,
+    out_offsets, out_targets, out_weights,
+    in_offsets, in_sources, in_edges,
+    count
+};
+
+struct binary_graph_header {
+    char magic[8];
+    std::uint32_t version;
+    // 0 for trivially copyable names, 1 for strings.
+    std::uint32_t name_kind;
+    std::uint64_t name_size;
+    std::uint64_t byte_order;
+    std::uint64_t node_count;
+    std::uint64_t edge_count;
+    struct {
+        std::uint64_t offset;
+        std::uint64_t size;
+    } sections[size_t(binary_graph_section::count)];
+};
+
+constexpr char binary_graph_magic[8] = {'G', 'R', 'A', 'P', 'H', 'B', 'I', 'N'};
+constexpr std::uint64_t binary_graph_byte_order = 0x0102030405060708;
+
+template <class T>
+constexpr bool binary_graph_string_names = std::is_same_v<T, std::string>;
+
+template <class T>
+constexpr bool binary_graph_supports = binary_graph_string_names<T> || std::is_trivially_copyable_v<T>;
+
+// Writes g to path in the format above.  Throws std::system_error if the
+// file can't be written.
+template <class T>
+void write_binary_graph(const frozen_graph<T> &g, const std::string &path) {
+    static_assert(binary_graph_supports<T>, "Names must be trivially copyable or std::string");
+    auto n = g.node_count();
+    auto m = g.edge_count();
+
+    // Gather the arrays we're going to write, as (pointer, bytes) pairs.
+    auto name_chars = std::string();
+    auto string_offsets = std::vector<std::uint64_t>();
+    if constexpr (binary_graph_string_names<T>) {
+        for(node_id i = 0; i < n; ++i) {
+            string_offsets.push_back(name_chars.size());
+            name_chars += g.name(i);
+        }
+        string_offsets.push_back(name_chars.size());
+    }
+    auto name_order = std::vector<node_id>(n);
+    for(node_id i = 0; i < n; ++i) {
+        name_order[i] = i;
+    }
+    std::sort(name_order.begin(), name_order.end(), [&](node_id a, node_id b) {
+        return g.name(a) < g.name(b);
+    });
+    auto names = std::vector<T>();
+    if constexpr (!binary_graph_string_names<T>) {
+        for(node_id i = 0; i < n; ++i) {
+            names.push_back(g.name(i));
+        }
+    }
+    auto out_offsets = std::vector<edge_id>(n + 1, 0);
+    auto in_offsets = std::vector<edge_id>(n + 1, 0);
+    auto out_targets = std::vector<node_id>();
+    auto out_weights = std::vector<double>();
+    out_targets.reserve(m);
+    out_weights.reserve(m);
+    for(node_id u = 0; u < n; ++u) {
+        g.for_each_out_edge(u, [&](node_id v, double weight) {
+            out_targets.push_back(v);
+            out_weights.push_back(weight);
+            in_offsets[v + 1]++;
+        });
+        out_offsets[u + 1] = out_targets.size();
+    }
+    for(node_id v = 0; v < n; ++v) {
+        in_offsets[v + 1] += in_offsets[v];
+    }
+    auto in_sources = std::vector<node_id>(m);
+    auto in_edges = std::vector<edge_id>(m);
+    auto in_fill = std::vector<edge_id>(in_offsets.begin(), in_offsets.end() - 1);
+    for(node_id u = 0; u < n; ++u) {
+        for(auto k = out_offsets[u]; k < out_offsets[u + 1]; ++k) {
+            auto slot = in_fill[out_targets[k]]++;
+            in_sources[slot] = u;
+            in_edges[slot] = k;
+        }
+    }
+
+    struct piece {
+        const void *data;
+        size_t bytes;
+    };
+    piece pieces[size_t(binary_graph_section::count)];
+    auto set = [&](binary_graph_section s, const auto &v) {
+        pieces[size_t(s)] = {v.data(), v.size() * sizeof(v[0])};
+    };
+    if constexpr (binary_graph_string_names<T>) {
+        set(binary_graph_section::names, string_offsets);
+    } else {
+        set(binary_graph_section::names, names);
+    }
+    pieces[size_t(binary_graph_section::name_chars)] = {name_chars.data(), name_chars.size()};
+    set(binary_graph_section::name_order, name_order);
+    set(binary_graph_section::out_offsets, out_offsets);
+    set(binary_graph_section::out_targets, out_targets);
+    set(binary_graph_section::out_weights, out_weights);
+    set(binary_graph_section::in_offsets, in_offsets);
+    set(binary_graph_section::in_sources, in_sources);
+    set(binary_graph_section::in_edges, in_edges);
+
+    auto header = binary_graph_header {};
+    std::memcpy(header.magic, binary_graph_magic, sizeof(header.magic));
+    header.version = binary_graph_version;
+    header.name_kind = binary_graph_string_names<T> ? 1 : 0;
+    header.name_size = binary_graph_string_names<T> ? 0 : sizeof(T);
+    header.byte_order = binary_graph_byte_order;
+    header.node_count = n;
+    header.edge_count = m;
+    auto align = [](std::uint64_t offset) {
+        return (offset + binary_graph_alignment - 1) / binary_graph_alignment * binary_graph_alignment;
+    };
+    std::uint64_t offset = align(sizeof(header));
+    for(size_t s = 0; s < size_t(binary_graph_section::count); ++s) {
+        header.sections[s] = {offset, pieces[s].bytes};
+        offset = align(offset + pieces[s].bytes);
+    }
+
+    auto out = std::ofstream(path, std::ios::binary | std::ios::trunc);
+    auto padding = std::vector<char>(binary_graph_alignment, 0);
+    auto position = std::uint64_t(0);
+    auto write = [&](const void *data, size_t bytes) {
+        out.write(static_cast<const char *>(data), std::streamsize(bytes));
+        position += bytes;
+    };
+    auto pad_to = [&](std::uint64_t target) {
+        write(padding.data(), target - position);
+    };
+    write(&header, sizeof(header));
+    for(size_t s = 0; s < size_t(binary_graph_section::count); ++s) {
+        pad_to(header.sections[s].offset);
+        write(pieces[s].data, pieces[s].bytes);
+    }
+    pad_to(offset);
+    out.close();
+    if(!out) {
+        throw std::system_error(errno, std::generic_category(), "Unable to write " + path);
+    }
+}
+
+// A graph file mapped into memory.  It offers the same read-only interface
+// as frozen_graph (node_count, name, id, for_each_out_edge, ...), so every
+// algorithm that runs on a frozen_graph runs on a mapped one, straight out
+// of the mapping.  The one difference is that name() returns a
+// std::string_view for string names, pointing into the mapping.
+//
+// Opening checks the header and that every section lies inside the file
+// and has the size the header's counts call for, and then makes one pass
+// over the offset and id arrays to check that every offset and id the
+// accessors follow stays in range, so a corrupt file is turned away
+// rather than read out of bounds.  That pass touches those pages once;
+// the weights are never read until a traversal needs them.
+template <class T>
+class mapped_graph {
+    static_assert(binary_graph_supports<T>, "Names must be trivially copyable or std::string");
+
+private:
+    mapped_file file;
+    const binary_graph_header *header = nullptr;
+    node_id n = 0;
+    size_t m = 0;
+
+    const T *names = nullptr;
+    const std::uint64_t *string_offsets = nullptr;
+    const char *name_chars = nullptr;
+    const node_id *name_order = nullptr;
+    const edge_id *out_offsets = nullptr;
+    const node_id *out_targets = nullptr;
+    const double *out_weights = nullptr;
+    const edge_id *in_offsets = nullptr;
+    const node_id *in_sources = nullptr;
+    const edge_id *in_edges = nullptr;
+
+    template <class U>
+    const U *section(binary_graph_section s, size_t count) {
+        auto &entry = header->sections[size_t(s)];
+        // Bound the count first, so that count * sizeof(U) can't wrap.
+        if(count > file.size() / sizeof(U) ||
+           entry.offset % binary_graph_alignment != 0 || entry.size != count * sizeof(U) ||
+           entry.offset > file.size() || entry.size > file.size() - entry.offset) {
+            throw std::domain_error("Corrupt graph file");
+        }
+        return reinterpret_cast<const U *>(file.data() + entry.offset);
+    }
+
+    // Whether offsets[0..n] starts at 0, never goes down, and ends at end.
+    template <class U>
+    bool offsets_valid(const U *offsets, std::uint64_t end) const {
+        if(offsets[0] != 0 || offsets[n] != end) {
+            return false;
+        }
+        for(node_id u = 0; u < n; ++u) {
+            if(offsets[u] > offsets[u + 1]) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    template <class U>
+    static bool all_below(const U *values, size_t count, std::uint64_t limit) {
+        return std::all_of(values, values + count, [&](U value) { return value < limit; });
+    }
+
+public:
+    // Throws std::system_error if the file can't be opened or mapped, and
+    // std::domain_error if it isn't a graph file this code can read.
+    explicit mapped_graph(const std::string &path) : file(path) {
+        if(file.size() < sizeof(binary_graph_header)) {
+            throw std::domain_error("Not a graph file");
+        }
+        header = reinterpret_cast<const binary_graph_header *>(file.data());
+        if(std::memcmp(header->magic, binary_graph_magic, sizeof(header->magic)) != 0) {
+            throw std::domain_error("Not a graph file");
+        }
+        if(header->byte_order != binary_graph_byte_order) {
+            throw std::domain_error("Graph file has the wrong byte order");
+        }
+        if(header->version != binary_graph_version) {
+            throw std::domain_error("Unsupported graph file version");
+        }
+        if(header->name_kind != (binary_graph_string_names<T> ? 1u : 0u) ||
+           header->name_size != (binary_graph_string_names<T> ? 0 : sizeof(T))) {
+            throw std::domain_error("Graph file has a different name type");
+        }
+        if(header->node_count >= no_node) {
+            throw std::domain_error("Corrupt graph file");
+        }
+        n = node_id(header->node_count);
+        m = size_t(header->edge_count);
+        if constexpr (binary_graph_string_names<T>) {
+            string_offsets = section<std::uint64_t>(binary_graph_section::names, n + 1);
+            name_chars = section<char>(binary_graph_section::name_chars, string_offsets[n]);
+        } else {
+            names = section<T>(binary_graph_section::names, n);
+        }
+        name_order = section<node_id>(binary_graph_section::name_order, n);
+        out_offsets = section<edge_id>(binary_graph_section::out_offsets, n + 1);
+        out_targets = section<node_id>(binary_graph_section::out_targets, m);
+        out_weights = section<double>(binary_graph_section::out_weights, m);
+        in_offsets = section<edge_id>(binary_graph_section::in_offsets, n + 1);
+        in_sources = section<node_id>(binary_graph_section::in_sources, m);
+        in_edges = section<edge_id>(binary_graph_section::in_edges, m);
+        if(!offsets_valid(out_offsets, m) || !offsets_valid(in_offsets, m) ||
+           !all_below(name_order, n, n) || !all_below(out_targets, m, n) ||
+           !all_below(in_sources, m, n) || !all_below(in_edges, m, m)) {
+            throw std::domain_error("Corrupt graph file");
+        }
+        if constexpr (binary_graph_string_names<T>) {
+            if(!offsets_valid(string_offsets, string_offsets[n])) {
+                throw std::domain_error("Corrupt graph file");
+            }
+        }
+        // find() binary searches name_order, so it has to be strictly in
+        // name order (which also rules out repeats).
+        for(node_id i = 0; i + 1 < n; ++i) {
+            if(!(name(name_order[i]) < name(name_order[i + 1]))) {
+                throw std::domain_error("Corrupt graph file");
+            }
+        }
+    }
+
+    mapped_graph(const mapped_graph &) = delete;
+    mapped_graph &operator=(const mapped_graph &) = delete;
+
+    node_id node_count() const {
+        return n;
+    }
+
+    size_t edge_count() const {
+        return m;
+    }
+
+    auto name(node_id node) const {
+        if constexpr (binary_graph_string_names<T>) {
+            return std::string_view(name_chars + string_offsets[node],
+                                    string_offsets[node + 1] - string_offsets[node]);
+        } else {
+            return names[node];
+        }
+    }
+
+    bool contains(const T &name) const {
+        return find(name) != no_node;
+    }
+
+    node_id id(const T &name) const {
+        auto node = find(name);
+        if(node == no_node) {
+            throw std::logic_error("Unable to find the node");
+        }
+        return node;
+    }
+
+    // Binary search of the sorted name order;  no_node if not found.
+    node_id find(const T &target) const {
+        auto key = [&]() {
+            if constexpr (binary_graph_string_names<T>) {
+                return std::string_view(target);
+            } else {
+                return target;
+            }
+        }();
+        auto first = name_order;
+        auto last = name_order + n;
+        auto itr = std::lower_bound(first, last, key, [&](node_id node, const auto &value) {
+            return name(node) < value;
+        });
+        if(itr == last || key < name(*itr)) {
+            return no_node;
+        }
+        return *itr;
+    }
+
+    size_t out_degree(node_id node) const {
+        return out_offsets[node + 1] - out_offsets[node];
+    }
+
+    size_t in_degree(node_id node) const {
+        return in_offsets[node + 1] - in_offsets[node];
+    }
+
+    std::span<const node_id> out_neighbors(node_id node) const {
+        return {out_targets + out_offsets[node], out_degree(node)};
+    }
+
+    std::span<const node_id> in_neighbors(node_id node) const {
+        return {in_sources + in_offsets[node], in_degree(node)};
+    }
+
+    template <class F>
+    void for_each_out_edge(node_id node, F &&f) const {
+        for(auto k = out_offsets[node]; k < out_offsets[node + 1]; ++k) {
+            f(out_targets[k], out_weights[k]);
+        }
+    }
+
+    template <class F>
+    void for_each_in_edge(node_id node, F &&f) const {
+        for(auto k = in_offsets[node]; k < in_offsets[node + 1]; ++k) {
+            f(in_sources[k], out_weights[in_edges[k]]);
+        }
+    }
+};
+
+void testBinaryGraph();
+
+#endif //BINARY_GRAPH_H
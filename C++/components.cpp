@@ -0,0 +1,94 @@
+#include "components.hpp"
+
+#include <cassert>
+#include <iostream>
+
+#include "compressed_graph.hpp"
+#include "graph_generators.hpp"
+#include "reference_search.hpp"
+
+// Checks both kinds of component against the definitions, worked out the
+// slow way with a search from every node:  weak components by a search that
+// ignores edge directions, strong ones by "a reaches b and b reaches a".
+// Sparse random graphs give plenty of small components alongside a big
+// one, so both halves of Afforest get used.
+
+static void check_dense(const component_labels &labels, node_id n) {
+    assert(labels.component.size() == n);
+    auto sizes = labels.sizes();
+    for(auto size : sizes) {
+        assert(size > 0);
+    }
+}
+
+template <class Graph>
+static void check_weak(const Graph &g, const component_labels &labels) {
+    check_dense(labels, g.node_count());
+    for(node_id a = 0; a < g.node_count(); ++a) {
+        auto hops = reference_hops(g, a, true);
+        for(node_id b = 0; b < g.node_count(); ++b) {
+            assert(labels.connected(a, b) == (hops[b] != no_hops));
+        }
+    }
+}
+
+template <class Graph>
+static void check_strong(const Graph &g, const component_labels &labels) {
+    check_dense(labels, g.node_count());
+    auto hops = std::vector<std::vector<std::uint32_t>>();
+    for(node_id a = 0; a < g.node_count(); ++a) {
+        hops.push_back(reference_hops(g, a));
+    }
+    for(node_id a = 0; a < g.node_count(); ++a) {
+        for(node_id b = 0; b < g.node_count(); ++b) {
+            assert(labels.connected(a, b) == (hops[a][b] != no_hops && hops[b][a] != no_hops));
+        }
+        // Reverse topological order between components.
+        g.for_each_out_edge(a, [&](node_id b, double) {
+            assert(labels.component[a] >= labels.component[b]);
+        });
+    }
+}
+
+void testComponents() {
+    std::cerr << "Initializing component tests" << std::endl;
+    auto pool = thread_pool(4);
+    auto serial = thread_pool(1);
+
+    for(auto seed = 1u; seed <= 4; ++seed) {
+        auto sparse = freeze(erdos_renyi_graph(300, 1.2, seed));
+        auto weak = weakly_connected_components(sparse, pool);
+        assert(weak.count > 1);
+        check_weak(sparse, weak);
+        check_weak(sparse, weakly_connected_components(sparse, serial));
+        check_weak(sparse, weakly_connected_components(compressed_graph<std::uint64_t>(sparse), pool));
+        check_strong(sparse, strongly_connected_components(sparse));
+    }
+    auto rmat = freeze(rmat_graph(9, 4));
+    check_weak(rmat, weakly_connected_components(rmat, pool));
+    check_strong(rmat, strongly_connected_components(rmat));
+    // No sampling at all still links everything in the last step.
+    check_weak(rmat, weakly_connected_components(rmat, pool, 0));
+
+    // A grid has edges both ways, so it's one component of both kinds.
+    auto grid = freeze(grid_graph(30, 40));
+    assert(weakly_connected_components(grid, pool).count == 1);
+    assert(strongly_connected_components(grid).count == 1);
+
+    // A chain too long to recurse down, closed into a ring:  one strong
+    // component;  left open, every node is its own.
+    auto chain = generated_graph();
+    chain.node_count = 200000;
+    for(node_id u = 0; u + 1 < chain.node_count; ++u) {
+        chain.edges.push_back({u, u + 1, 1});
+    }
+    assert(strongly_connected_components(freeze(chain)).count == chain.node_count);
+    chain.edges.push_back({chain.node_count - 1, 0, 1});
+    auto ring = freeze(chain);
+    assert(strongly_connected_components(ring).count == 1);
+    assert(weakly_connected_components(ring, pool).count == 1);
+
+    auto empty = freeze(generated_graph());
+    assert(weakly_connected_components(empty, pool).count == 0);
+    assert(strongly_connected_components(empty).count == 0);
+}
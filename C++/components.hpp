@@ -0,0 +1,245 @@
+#ifndef COMPONENTS_H
+#define COMPONENTS_H
+
+#include <atomic>
+#include <cstdint>
+#include <random>
+#include <span>
+#include <unordered_map>
+#include <vector>
+
+#include "frozen_graph.hpp"
+#include "thread_pool.hpp"
+
+// Connected components, for rejecting impossible queries before routing.
+//
+// Two nodes in different weakly connected components (connected ignoring
+// edge directions) can't reach each other either way, so once every node
+// has a component number, "is it even possible" is one comparison.  The
+// numbers are dense (0 to count - 1), so they can index an array.
+//
+// weakly_connected_components is Afforest (Sutton, Ben-Nun and Barak,
+// "Optimizing Parallel Graph Connectivity Computation via Subgraph
+// Sampling", IPDPS 2018), a parallel union-find.  Every node starts as its
+// own tree;  linking an edge's two ends hooks the higher numbered root
+// under the lower with a compare and swap (retrying if another thread got
+// there first), and compressing points every node straight at its root.
+// The trick is to link only the first couple of edges of each node first:
+// on real graphs that's already enough to pull most nodes into one giant
+// component, and then the rest of the edges only need looking at for the
+// nodes outside it (an edge with both ends in the giant component can't
+// change anything).
+//
+// strongly_connected_components is Tarjan's algorithm, done iteratively
+// (with an explicit stack rather than recursion, so a long path can't
+// overflow the call stack).  Its components come out in reverse
+// topological order:  if there is an edge from component a to a different
+// component b, then a > b.  Two nodes are mutually reachable exactly when
+// they're in the same strongly connected component.
+
+struct component_labels {
+    // component[u] is u's component, from 0 to count - 1.
+    std::vector<node_id> component;
+    node_id count = 0;
+
+    // Whether a and b are in the same component.
+    bool connected(node_id a, node_id b) const {
+        return component[a] == component[b];
+    }
+
+    // How many nodes are in each component.
+    std::vector<size_t> sizes() const {
+        auto result = std::vector<size_t>(count, 0);
+        for(auto c : component) {
+            result[c]++;
+        }
+        return result;
+    }
+};
+
+// Calls f(v) for the out neighbours of u from the first-th on (up to
+// last-th, exclusive), without decoding all of them where the graph can
+// hand out its neighbours directly.
+template <class Graph, class F>
+void for_each_out_neighbor_between(const Graph &g, node_id u, size_t first, size_t last, F &&f) {
+    if constexpr (requires { g.out_neighbors(u); }) {
+        auto neighbors = g.out_neighbors(u);
+        for(auto k = first; k < std::min(last, neighbors.size()); ++k) {
+            f(neighbors[k]);
+        }
+    } else {
+        size_t k = 0;
+        g.for_each_out_edge(u, [&](node_id v, double) {
+            if(k >= first && k < last) {
+                f(v);
+            }
+            k++;
+        });
+    }
+}
+
+template <class Graph>
+component_labels weakly_connected_components(const Graph &g, thread_pool &pool, size_t sampled_edges = 2) {
+    auto n = g.node_count();
+    auto parent = std::vector<node_id>(n);
+    for(node_id u = 0; u < n; ++u) {
+        parent[u] = u;
+    }
+    auto at = [&](node_id u) { return std::atomic_ref<node_id>(parent[u]); };
+
+    auto link = [&](node_id u, node_id v) {
+        auto a = at(u).load(std::memory_order_relaxed);
+        auto b = at(v).load(std::memory_order_relaxed);
+        while(a != b) {
+            auto high = std::max(a, b);
+            auto low = std::min(a, b);
+            auto high_parent = at(high).load(std::memory_order_relaxed);
+            if(high_parent == low) {
+                return;
+            }
+            if(high_parent == high && at(high).compare_exchange_strong(high_parent, low, std::memory_order_relaxed)) {
+                return;
+            }
+            a = at(at(high).load(std::memory_order_relaxed)).load(std::memory_order_relaxed);
+            b = at(low).load(std::memory_order_relaxed);
+        }
+    };
+    // Parents are always lower numbered than their children, so this
+    // terminates, whatever other threads are doing.
+    auto compress = [&]() {
+        pool.parallel_for(n, [&](unsigned, size_t i) {
+            auto u = node_id(i);
+            while(true) {
+                auto p = at(u).load(std::memory_order_relaxed);
+                auto grandparent = at(p).load(std::memory_order_relaxed);
+                if(p == grandparent) {
+                    break;
+                }
+                at(u).store(grandparent, std::memory_order_relaxed);
+            }
+        }, 1024);
+    };
+
+    for(size_t round = 0; round < sampled_edges; ++round) {
+        pool.parallel_for(n, [&](unsigned, size_t i) {
+            for_each_out_neighbor_between(g, node_id(i), round, round + 1, [&](node_id v) { link(node_id(i), v); });
+        }, 1024);
+        compress();
+    }
+
+    // The most common root in a random sample of nodes is almost certainly
+    // the giant component, if there is one.
+    node_id giant = no_node;
+    if(n > 0) {
+        auto rng = std::mt19937(n);
+        auto pick = std::uniform_int_distribution<node_id>(0, n - 1);
+        auto counts = std::unordered_map<node_id, size_t>();
+        size_t best = 0;
+        for(auto k = 0; k < 1024; ++k) {
+            auto root = parent[pick(rng)];
+            if(++counts[root] > best) {
+                best = counts[root];
+                giant = root;
+            }
+        }
+    }
+
+    // Now the remaining edges, for the nodes outside the giant component.
+    // An edge from a giant component node to an outside node is seen from
+    // the other end, through its in edges.
+    pool.parallel_for(n, [&](unsigned, size_t i) {
+        auto u = node_id(i);
+        if(at(u).load(std::memory_order_relaxed) == giant) {
+            return;
+        }
+        for_each_out_neighbor_between(g, u, sampled_edges, SIZE_MAX, [&](node_id v) { link(u, v); });
+        g.for_each_in_edge(u, [&](node_id v, double) { link(u, v); });
+    }, 1024);
+    compress();
+
+    // Finally number the roots densely, in order of their lowest node.
+    auto result = component_labels();
+    result.component.resize(n);
+    auto dense = std::vector<node_id>(n, no_node);
+    for(node_id u = 0; u < n; ++u) {
+        auto root = parent[u];
+        if(dense[root] == no_node) {
+            dense[root] = result.count++;
+        }
+        result.component[u] = dense[root];
+    }
+    return result;
+}
+
+template <class Graph>
+component_labels strongly_connected_components(const Graph &g) {
+    auto n = g.node_count();
+    auto result = component_labels();
+    result.component.assign(n, no_node);
+    constexpr node_id unvisited = no_node;
+    auto index = std::vector<node_id>(n, unvisited);
+    auto low = std::vector<node_id>(n);
+    // Nodes visited but not yet given a component, in visiting order.
+    auto tarjan_stack = std::vector<node_id>();
+    // The search path:  each node on it, with the part of neighbors holding
+    // the out neighbours it still has to look at.  Copying a node's
+    // neighbours out when it is entered lets the search pause part way
+    // through them, which for_each_out_edge on its own can't.
+    struct frame {
+        node_id node;
+        size_t next;
+        size_t begin;
+    };
+    auto path = std::vector<frame>();
+    auto neighbors = std::vector<node_id>();
+    node_id next_index = 0;
+
+    auto enter = [&](node_id u) {
+        index[u] = low[u] = next_index++;
+        tarjan_stack.push_back(u);
+        auto begin = neighbors.size();
+        g.for_each_out_edge(u, [&](node_id v, double) { neighbors.push_back(v); });
+        path.push_back({u, begin, begin});
+    };
+
+    for(node_id root = 0; root < n; ++root) {
+        if(index[root] != unvisited) {
+            continue;
+        }
+        enter(root);
+        while(!path.empty()) {
+            auto &top = path.back();
+            auto u = top.node;
+            if(top.next < neighbors.size()) {
+                auto v = neighbors[top.next++];
+                if(index[v] == unvisited) {
+                    enter(v);
+                } else if(result.component[v] == no_node) {
+                    // Still on the Tarjan stack.
+                    low[u] = std::min(low[u], index[v]);
+                }
+                continue;
+            }
+            neighbors.resize(top.begin);
+            path.pop_back();
+            if(low[u] == index[u]) {
+                node_id v;
+                do {
+                    v = tarjan_stack.back();
+                    tarjan_stack.pop_back();
+                    result.component[v] = result.count;
+                } while(v != u);
+                result.count++;
+            }
+            if(!path.empty()) {
+                auto parent = path.back().node;
+                low[parent] = std::min(low[parent], low[u]);
+            }
+        }
+    }
+    return result;
+}
+
+void testComponents();
+
+#endif //COMPONENTS_H
@@ -0,0 +1,90 @@
+#include "compressed_graph.hpp"
+
+#include <cassert>
+#include <iostream>
+#include <random>
+
+#include "dijkstra_workspace.hpp"
+
+// Compresses random graphs and checks that every node decodes to the same
+// edges as the frozen graph it came from.  With few distinct weights the
+// shortest paths must come out exactly the same;  with lots of them the
+// weights are rounded, and the distances must stay within the error bound.
+
+static frozen_graph<int> random_frozen(int count, int edges_per_node, bool few_weights) {
+    auto rng = std::default_random_engine {};
+    auto pick = std::uniform_int_distribution<int>(0, count - 1);
+    auto whole = std::uniform_int_distribution<int>(1, 300);
+    auto real = std::uniform_real_distribution<double>(0.01, 1000.0);
+    auto names = std::vector<int>();
+    for(auto i = 0; i < count; ++i) {
+        names.push_back(i * 3);
+    }
+    auto edges = std::vector<frozen_edge>();
+    for(auto i = 0; i < count * edges_per_node; ++i) {
+        auto w = few_weights ? double(whole(rng)) : real(rng);
+        // Some long jumps so that the varints need more than one byte.
+        auto a = node_id(pick(rng));
+        auto b = i % 5 == 0 ? node_id(pick(rng)) : node_id((a + i % 7) % count);
+        edges.push_back({a, b, w});
+    }
+    return frozen_graph<int>(std::move(names), edges);
+}
+
+static std::vector<std::pair<node_id, double>> sorted_edges(auto &&for_each) {
+    auto list = std::vector<std::pair<node_id, double>>();
+    for_each([&](node_id v, double w) { list.emplace_back(v, w); });
+    std::sort(list.begin(), list.end());
+    return list;
+}
+
+static void check(const frozen_graph<int> &frozen) {
+    auto compressed = compressed_graph<int>(frozen);
+    assert(compressed.node_count() == frozen.node_count());
+    assert(compressed.edge_count() == frozen.edge_count());
+    auto error = compressed.max_relative_error();
+    assert(compressed.exact_weights() == (error == 0));
+
+    for(node_id u = 0; u < frozen.node_count(); ++u) {
+        assert(compressed.name(u) == frozen.name(u));
+        assert(compressed.id(frozen.name(u)) == u);
+        auto sides = {std::pair {sorted_edges([&](auto f) { frozen.for_each_out_edge(u, f); }),
+                                 sorted_edges([&](auto f) { compressed.for_each_out_edge(u, f); })},
+                      std::pair {sorted_edges([&](auto f) { frozen.for_each_in_edge(u, f); }),
+                                 sorted_edges([&](auto f) { compressed.for_each_in_edge(u, f); })}};
+        for(auto &[expected, actual] : sides) {
+            assert(expected.size() == actual.size());
+            for(size_t k = 0; k < expected.size(); ++k) {
+                assert(expected[k].first == actual[k].first);
+                assert(std::abs(expected[k].second - actual[k].second) <= expected[k].second * error * 1.000001);
+            }
+        }
+    }
+
+    auto expected = dijkstra_workspace();
+    auto actual = dijkstra_workspace();
+    for(node_id source = 0; source < std::min(frozen.node_count(), node_id(5)); ++source) {
+        expected.run(frozen, source);
+        actual.run(compressed, source);
+        for(node_id u = 0; u < frozen.node_count(); ++u) {
+            auto d = expected.distance(u);
+            assert(actual.distance(u) == d || (!compressed.exact_weights() && d != HUGE_VAL &&
+                                               std::abs(d - actual.distance(u)) <= d * error * 1.000001));
+        }
+    }
+}
+
+void testCompressedGraph() {
+    std::cerr << "Initializing compressed graph tests" << std::endl;
+    auto few = random_frozen(2000, 8, true);
+    check(few);
+    assert(compressed_graph<int>(few).exact_weights());
+    // Smaller than the frozen_graph's 4 + 8 bytes per edge each way.
+    assert(compressed_graph<int>(few).adjacency_bytes() < few.edge_count() * 2 * 6);
+
+    auto many = random_frozen(20000, 5, false);
+    check(many);
+    assert(!compressed_graph<int>(many).exact_weights());
+
+    check(frozen_graph<int>({1, 2}, {}));
+}
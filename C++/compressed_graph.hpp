@@ -0,0 +1,231 @@
+#ifndef COMPRESSED_GRAPH_H
+#define COMPRESSED_GRAPH_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <stdexcept>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "frozen_graph.hpp"
+
+// A frozen_graph squeezed down further, for graphs that would otherwise not
+// fit in memory.  A frozen_graph spends 4 bytes on every edge's target and 8
+// on its weight (and the same again for the in edges);  here a typical edge
+// takes 2 or 3 bytes.
+//
+// Neighbour lists:  each node's neighbours are sorted, so they can be stored
+// as the gaps between one and the next, which are mostly small numbers.
+// Those go in as varints (LEB128):  7 bits per byte, with the top bit set
+// on every byte but the last.  A neighbour within 127 of the previous one
+// costs one byte.
+//
+// Weights:  most graphs have far fewer distinct weights than edges (road
+// networks in whole metres or seconds, unit weights, ...).  So the distinct
+// weights go in a table, and each edge stores just its index in the table,
+// in one byte if there are at most 256 of them and two otherwise.  If there
+// are more than 65536 distinct weights the table instead holds 65536 levels
+// spaced geometrically between the smallest and largest weight, and each
+// weight is rounded to the nearest level, which keeps the *relative* error
+// the same for small and large weights.  exact_weights() says which
+// happened, and max_relative_error() bounds the rounding.
+//
+// Everything is decoded on the fly in for_each_out_edge/for_each_in_edge,
+// so the algorithms run over it unchanged (the decoding is a few shifts and
+// adds per edge, which is cheap next to the cache misses it saves).  The
+// edges come out in neighbour order, not the order they were added in.
+
+template <class T>
+class compressed_graph {
+private:
+    std::vector<T> names;
+    std::unordered_map<T, node_id> ids;
+    size_t edges = 0;
+
+    // Where each node's encoded edges start in out_bytes/in_bytes.
+    std::vector<edge_id> out_offsets;
+    std::vector<std::uint8_t> out_bytes;
+    std::vector<edge_id> in_offsets;
+    std::vector<std::uint8_t> in_bytes;
+
+    std::vector<double> weight_levels;
+    unsigned weight_bytes = 1;
+    bool exact = true;
+    double relative_error = 0;
+
+    static void put_varint(std::vector<std::uint8_t> &bytes, node_id value) {
+        while(value >= 0x80) {
+            bytes.push_back(std::uint8_t(value | 0x80));
+            value >>= 7;
+        }
+        bytes.push_back(std::uint8_t(value));
+    }
+
+    static node_id get_varint(const std::uint8_t *&p) {
+        node_id value = *p & 0x7f;
+        unsigned shift = 7;
+        while(*p++ & 0x80) {
+            value |= node_id(*p & 0x7f) << shift;
+            shift += 7;
+        }
+        return value;
+    }
+
+    // Works out the weight table from every weight in the graph.
+    void choose_levels(std::vector<double> weights) {
+        std::sort(weights.begin(), weights.end());
+        weights.erase(std::unique(weights.begin(), weights.end()), weights.end());
+        if(weights.size() <= 65536) {
+            weight_levels = std::move(weights);
+        } else {
+            exact = false;
+            auto ratio = std::pow(weights.back() / weights.front(), 1.0 / 65535);
+            weight_levels.resize(65536);
+            for(size_t i = 0; i < weight_levels.size(); ++i) {
+                weight_levels[i] = weights.front() * std::pow(ratio, double(i));
+            }
+            weight_levels.back() = weights.back();
+            relative_error = std::sqrt(ratio) - 1;
+        }
+        weight_bytes = weight_levels.size() <= 256 ? 1 : 2;
+    }
+
+    unsigned level_of(double weight) const {
+        if(exact) {
+            return unsigned(std::lower_bound(weight_levels.begin(), weight_levels.end(), weight) - weight_levels.begin());
+        }
+        // The nearest level in log space, which is what the error bound is for.
+        auto upper = std::lower_bound(weight_levels.begin(), weight_levels.end(), weight);
+        if(upper == weight_levels.end()) {
+            return unsigned(weight_levels.size() - 1);
+        }
+        if(upper != weight_levels.begin() && weight / upper[-1] < *upper / weight) {
+            --upper;
+        }
+        return unsigned(upper - weight_levels.begin());
+    }
+
+    // Encodes one side (out or in) of the graph.  neighbours(u, list) fills
+    // list with u's (neighbour, weight) pairs.
+    template <class F>
+    void encode(std::vector<edge_id> &offsets, std::vector<std::uint8_t> &bytes, F &&neighbours) {
+        auto n = node_count();
+        offsets.resize(n + 1);
+        auto list = std::vector<std::pair<node_id, double>>();
+        for(node_id u = 0; u < n; ++u) {
+            offsets[u] = bytes.size();
+            list.clear();
+            neighbours(u, list);
+            std::sort(list.begin(), list.end());
+            node_id previous = 0;
+            for(auto [v, w] : list) {
+                put_varint(bytes, v - previous);
+                previous = v;
+                auto level = level_of(w);
+                bytes.push_back(std::uint8_t(level));
+                if(weight_bytes == 2) {
+                    bytes.push_back(std::uint8_t(level >> 8));
+                }
+            }
+        }
+        offsets[n] = bytes.size();
+        bytes.shrink_to_fit();
+    }
+
+    template <class F>
+    void decode(const std::vector<edge_id> &offsets, const std::vector<std::uint8_t> &bytes, node_id node, F &&f) const {
+        auto p = bytes.data() + offsets[node];
+        auto end = bytes.data() + offsets[node + 1];
+        node_id neighbour = 0;
+        while(p != end) {
+            neighbour += get_varint(p);
+            unsigned level = *p++;
+            if(weight_bytes == 2) {
+                level |= unsigned(*p++) << 8;
+            }
+            f(neighbour, weight_levels[level]);
+        }
+    }
+
+public:
+    explicit compressed_graph(const frozen_graph<T> &g) : edges(g.edge_count()) {
+        names.reserve(g.node_count());
+        ids.reserve(g.node_count());
+        for(node_id u = 0; u < g.node_count(); ++u) {
+            names.push_back(g.name(u));
+            ids[g.name(u)] = u;
+        }
+        auto weights = std::vector<double>();
+        weights.reserve(edges);
+        for(node_id u = 0; u < g.node_count(); ++u) {
+            g.for_each_out_edge(u, [&](node_id, double w) { weights.push_back(w); });
+        }
+        choose_levels(std::move(weights));
+        encode(out_offsets, out_bytes, [&](node_id u, auto &list) {
+            g.for_each_out_edge(u, [&](node_id v, double w) { list.emplace_back(v, w); });
+        });
+        encode(in_offsets, in_bytes, [&](node_id u, auto &list) {
+            g.for_each_in_edge(u, [&](node_id v, double w) { list.emplace_back(v, w); });
+        });
+    }
+
+    node_id node_count() const {
+        return static_cast<node_id>(names.size());
+    }
+
+    size_t edge_count() const {
+        return edges;
+    }
+
+    const T &name(node_id node) const {
+        return names[node];
+    }
+
+    bool contains(const T &name) const {
+        return ids.contains(name);
+    }
+
+    node_id id(const T &name) const {
+        auto itr = ids.find(name);
+        if(itr == ids.end()) {
+            throw std::logic_error("Unable to find the node");
+        }
+        return itr->second;
+    }
+
+    // True if every weight is stored exactly, in which case shortest paths
+    // come out exactly as they would on the frozen_graph.
+    bool exact_weights() const {
+        return exact;
+    }
+
+    // No stored weight differs from the original by more than this fraction
+    // of it (so no path length does either).  0 when the weights are exact.
+    double max_relative_error() const {
+        return relative_error;
+    }
+
+    // Bytes used by the adjacency (both directions, offsets and the weight
+    // table), for comparing against other representations.
+    size_t adjacency_bytes() const {
+        return out_bytes.size() + in_bytes.size() +
+               (out_offsets.size() + in_offsets.size()) * sizeof(edge_id) +
+               weight_levels.size() * sizeof(double);
+    }
+
+    template <class F>
+    void for_each_out_edge(node_id node, F &&f) const {
+        decode(out_offsets, out_bytes, node, f);
+    }
+
+    template <class F>
+    void for_each_in_edge(node_id node, F &&f) const {
+        decode(in_offsets, in_bytes, node, f);
+    }
+};
+
+void testCompressedGraph();
+
+#endif //COMPRESSED_GRAPH_H
@@ -0,0 +1,122 @@
+#include "concurrent_graph.hpp"
+
+#include <cassert>
+#include <set>
+#include <thread>
+
+#include "delta_stepping.hpp"
+#include "dijkstra_workspace.hpp"
+#include "graph_generators.hpp"
+
+// Several producer threads create nodes and then stream in edges at the
+// same time, while a reader thread keeps running traversals over views of
+// the half-built graph.  Once everyone is done, every edge has to be there
+// exactly once, and shortest paths over the result have to agree with the
+// same graph built the ordinary way.
+
+void testConcurrentGraph() {
+    std::cerr << "Initializing concurrent graph tests" << std::endl;
+    // Enough nodes to need several segments, and enough edges per node to
+    // need several blocks.
+    const int count = 3000;
+    const int producers = 4;
+    auto g = concurrent_graph<int>();
+
+    // A power law graph, so that a few hub nodes get lots of edges from
+    // every producer at once.
+    auto generated = power_law_graph(count, 8, 2.2);
+    auto links = std::set<std::pair<int, int>>();
+    auto work = std::vector<std::vector<std::tuple<int, int, double>>>(producers);
+    for(size_t k = 0; k < generated.edges.size(); ++k) {
+        auto &e = generated.edges[k];
+        links.insert({e.start, e.end});
+        work[k % producers].emplace_back(e.start, e.end, e.weight);
+    }
+
+    std::atomic<int> created = 0;
+    std::atomic<bool> finished = false;
+    auto reader = std::thread([&] {
+        auto workspace = dijkstra_workspace();
+        while(!finished.load()) {
+            auto view = g.view();
+            if(view.node_count() == 0) {
+                continue;
+            }
+            workspace.run(view, 0);
+            for(node_id i = 0; i < view.node_count(); ++i) {
+                assert(workspace.distance(i) == HUGE_VAL || workspace.distance(i) >= 0);
+                // Every node a view counts is fully created, even while
+                // producers are still creating later ones.
+                assert(view.id(view.name(i)) == i);
+            }
+        }
+    });
+
+    auto threads = std::vector<std::thread>();
+    for(auto p = 0; p < producers; ++p) {
+        threads.emplace_back([&, p] {
+            for(auto i = p; i < count; i += producers) {
+                g.create_node(i);
+            }
+            created++;
+            while(created.load() < producers) {
+                std::this_thread::yield();
+            }
+            for(auto &[a, b, w] : work[p]) {
+                g.create_link(a, b, w);
+            }
+        });
+    }
+    for(auto &t : threads) {
+        t.join();
+    }
+    finished = true;
+    reader.join();
+
+    assert(g.edge_count() == links.size());
+    auto seen = std::set<std::pair<int, int>>();
+    auto view = g.view();
+    assert(view.node_count() == node_id(count));
+    size_t in_total = 0;
+    for(node_id u = 0; u < view.node_count(); ++u) {
+        assert(g.id(g.name(u)) == u);
+        view.for_each_out_edge(u, [&](node_id v, double) {
+            assert(seen.insert({g.name(u), g.name(v)}).second);
+        });
+        view.for_each_in_edge(u, [&](node_id, double) {
+            in_total++;
+        });
+    }
+    assert(seen == links);
+    assert(in_total == links.size());
+
+    // Compare against the same edges in an ordinary graph<int>.
+    auto plain = build_graph<int>(generated);
+    auto workspace = dijkstra_workspace();
+    workspace.run(view, view.id(0));
+    auto steps = 0;
+    for(auto step : dijkstra_traversal<int>(plain, 0)) {
+        assert(workspace.distance(view.id(step->current->name)) == step->distance);
+        steps++;
+    }
+    auto pool = thread_pool(4);
+    auto frozen = g.freeze();
+    auto result = delta_stepping(frozen, frozen.id(0), pool);
+    auto reached = 0;
+    for(node_id i = 0; i < frozen.node_count(); ++i) {
+        assert(result.distance[i] == workspace.distance(i));
+        reached += result.distance[i] != HUGE_VAL;
+    }
+    assert(reached == steps);
+
+    auto failed = false;
+    try {
+        g.create_node(0);
+    } catch(std::domain_error &) {
+        failed = true;
+    }
+    assert(failed);
+    // The failed call didn't use up an id.
+    assert(g.create_node(count) == node_id(count));
+    assert(g.view().node_count() == node_id(count + 1));
+}
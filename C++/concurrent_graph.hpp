@@ -0,0 +1,404 @@
+#ifndef CONCURRENT_GRAPH_H
+#define CONCURRENT_GRAPH_H
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <shared_mutex>
+#include <stdexcept>
+#include <thread>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+
+#include "frozen_graph.hpp"
+
+// A graph for streaming ingest:  create_node and create_link can be called
+// from any number of threads at once, and traversals can run while they do.
+//
+// There are two parts to making that work without a global lock.
+//
+// Finding a node by name goes through a hash table split into independent
+// shards, each with its own reader/writer lock.  A name always lives in the
+// same shard, so creating a node only locks the one shard it falls in, and
+// looking a name up only takes that shard's lock in shared mode, which any
+// number of threads can hold at once.
+//
+// The edges are where the volume is, and adding one takes no lock at all.
+// Each node keeps its edges in a linked list of fixed size blocks.  To add
+// an edge a thread atomically bumps the head block's "reserved" counter,
+// which hands it a slot nobody else will ever write;  it fills the slot in,
+// then sets the slot's ready flag.  If the head block is full, the thread
+// makes a new block holding its edge and swings the head pointer to it with
+// a compare-and-swap (if someone else got there first, it throws its block
+// away and tries again with theirs).  Blocks are never modified once full
+// and never freed until the whole graph goes away, so a reader can walk the
+// list at any time and simply skip slots whose ready flag isn't set yet.
+//
+// The nodes themselves live in a segmented array:  segment k holds twice as
+// many nodes as segment k-1, and segments are allocated (again with a
+// compare-and-swap) the first time an id falls in them.  So a node, once
+// created, never moves, and looking one up by id needs no lock either.
+// Ids are claimed from one counter, but a node only counts as created (for
+// views and create_link) once a second counter, bumped strictly in id
+// order, has passed it:  so everything below that count has its slot and
+// name in place, even while later ids are still being filled in.
+//
+// Unlike graph<T>, create_link doesn't reject a second edge between the
+// same two nodes:  there is no way to check for one and add the edge as one
+// atomic step without a lock.  A repeated edge is simply a parallel edge,
+// and every traversal here copes with those.
+
+template <class T>
+class concurrent_graph_view;
+
+template <class T>
+class concurrent_graph {
+private:
+    static constexpr size_t block_size = 16;
+    static constexpr size_t shard_count = 64;
+    static constexpr size_t first_segment = 1024;
+    static constexpr size_t segment_count = 32;
+
+    struct edge_entry {
+        node_id other;
+        double weight;
+        std::atomic<bool> ready;
+    };
+
+    struct edge_block {
+        edge_block *const next;
+        std::atomic<std::uint32_t> reserved;
+        std::array<edge_entry, block_size> entries;
+
+        explicit edge_block(edge_block *nextIn) : next(nextIn), reserved(0), entries() {
+        }
+    };
+
+    struct node_slot {
+        std::optional<T> name;
+        std::atomic<edge_block *> out_edges = nullptr;
+        std::atomic<edge_block *> in_edges = nullptr;
+    };
+
+    struct alignas(64) shard {
+        mutable std::shared_mutex mutex;
+        std::unordered_map<T, node_id> ids;
+    };
+
+    std::array<shard, shard_count> shards {};
+    std::array<std::atomic<node_slot *>, segment_count> segments {};
+    // Ids handed out, and ids whose node is fully in place (always a prefix
+    // of the handed out ones).
+    std::atomic<node_id> allocated = 0;
+    std::atomic<node_id> constructed = 0;
+    std::atomic<size_t> edges = 0;
+
+    shard &shard_for(const T &name) {
+        return shards[std::hash<T>{}(name) % shard_count];
+    }
+
+    const shard &shard_for(const T &name) const {
+        return shards[std::hash<T>{}(name) % shard_count];
+    }
+
+    // Segment k starts at first_segment * (2^k - 1) and holds
+    // first_segment * 2^k nodes.
+    static size_t segment_of(node_id node) {
+        return std::bit_width(node / first_segment + 1) - 1;
+    }
+
+    static size_t segment_start(size_t segment) {
+        return first_segment * ((size_t(1) << segment) - 1);
+    }
+
+    node_slot &slot(node_id node) const {
+        auto segment = segment_of(node);
+        return segments[segment].load(std::memory_order_acquire)[node - segment_start(segment)];
+    }
+
+    // Like slot(), but for an id that may have been handed out by
+    // create_node on another thread that hasn't finished with it yet:  null
+    // unless the node is fully in place.
+    const node_slot *find_slot(node_id node) const {
+        if(node >= constructed.load(std::memory_order_acquire)) {
+            return nullptr;
+        }
+        return &slot(node);
+    }
+
+    // Makes sure the segment node falls in exists, throwing if node is past
+    // the last segment.
+    void allocate_segment(node_id node) {
+        auto segment = segment_of(node);
+        if(node == no_node || segment >= segment_count) {
+            throw std::domain_error("Too many nodes for a concurrent graph");
+        }
+        auto existing = segments[segment].load(std::memory_order_acquire);
+        if(existing == nullptr) {
+            auto fresh = new node_slot[first_segment << segment];
+            if(!segments[segment].compare_exchange_strong(existing, fresh, std::memory_order_acq_rel)) {
+                delete[] fresh;
+            }
+        }
+    }
+
+    // Claims the next id, only once its segment exists, so that nothing
+    // after this can fail and leave a claimed id without a slot.
+    node_id claim_id() {
+        auto id = allocated.load(std::memory_order_relaxed);
+        do {
+            allocate_segment(id);
+        } while(!allocated.compare_exchange_weak(id, id + 1, std::memory_order_relaxed));
+        return id;
+    }
+
+    // Counts id as created, once every lower id has been:  each is only
+    // waiting on create_node calls that already hold their id, which
+    // can't fail any more, so this never waits long.
+    void publish(node_id id) {
+        auto expected = id;
+        while(!constructed.compare_exchange_weak(expected, id + 1, std::memory_order_release,
+                                                 std::memory_order_relaxed)) {
+            expected = id;
+            std::this_thread::yield();
+        }
+    }
+
+    static void append(std::atomic<edge_block *> &head, node_id other, double weight) {
+        auto block = head.load(std::memory_order_acquire);
+        while(true) {
+            if(block != nullptr) {
+                auto index = block->reserved.fetch_add(1, std::memory_order_relaxed);
+                if(index < block_size) {
+                    auto &entry = block->entries[index];
+                    entry.other = other;
+                    entry.weight = weight;
+                    entry.ready.store(true, std::memory_order_release);
+                    return;
+                }
+            }
+            auto fresh = new edge_block(block);
+            fresh->entries[0].other = other;
+            fresh->entries[0].weight = weight;
+            fresh->entries[0].ready.store(true, std::memory_order_relaxed);
+            fresh->reserved.store(1, std::memory_order_relaxed);
+            // On failure this reloads block with the new head, and we retry.
+            if(head.compare_exchange_strong(block, fresh, std::memory_order_acq_rel)) {
+                return;
+            }
+            delete fresh;
+        }
+    }
+
+    template <class F>
+    static void walk(const std::atomic<edge_block *> &head, F &&f) {
+        for(auto block = head.load(std::memory_order_acquire); block != nullptr; block = block->next) {
+            auto count = std::min<size_t>(block->reserved.load(std::memory_order_acquire), block_size);
+            for(size_t i = 0; i < count; ++i) {
+                auto &entry = block->entries[i];
+                if(entry.ready.load(std::memory_order_acquire)) {
+                    f(entry.other, entry.weight);
+                }
+            }
+        }
+    }
+
+    static void free_blocks(edge_block *block) {
+        while(block != nullptr) {
+            auto next = block->next;
+            delete block;
+            block = next;
+        }
+    }
+
+    friend concurrent_graph_view<T>;
+
+public:
+    concurrent_graph() = default;
+    concurrent_graph(const concurrent_graph &) = delete;
+    concurrent_graph &operator=(const concurrent_graph &) = delete;
+
+    // Not safe to run while other threads are still using the graph.
+    ~concurrent_graph() {
+        auto count = constructed.load();
+        for(node_id i = 0; i < count; ++i) {
+            free_blocks(slot(i).out_edges.load());
+            free_blocks(slot(i).in_edges.load());
+        }
+        for(auto &segment : segments) {
+            delete[] segment.load();
+        }
+    }
+
+    // Returns the new node's id.
+    node_id create_node(T name) {
+        // Moving the name into its slot is the one step after the id is
+        // claimed, and it mustn't fail (see publish).
+        static_assert(std::is_nothrow_move_constructible_v<T>);
+        auto &s = shard_for(name);
+        node_id id;
+        {
+            std::unique_lock lock(s.mutex);
+            // Everything that can throw happens before the id is claimed.
+            auto [entry, inserted] = s.ids.try_emplace(name, no_node);
+            if(!inserted) {
+                throw std::domain_error("Node already exists");
+            }
+            try {
+                id = claim_id();
+            } catch(...) {
+                s.ids.erase(entry);
+                throw;
+            }
+            slot(id).name.emplace(std::move(name));
+            entry->second = id;
+        }
+        publish(id);
+        return id;
+    }
+
+    bool contains(const T &name) const {
+        auto &s = shard_for(name);
+        std::shared_lock lock(s.mutex);
+        return s.ids.contains(name);
+    }
+
+    node_id id(const T &name) const {
+        auto &s = shard_for(name);
+        std::shared_lock lock(s.mutex);
+        auto itr = s.ids.find(name);
+        if(itr == s.ids.end()) {
+            throw std::logic_error("Unable to find the node");
+        }
+        return itr->second;
+    }
+
+    void create_link(node_id start, node_id end, double weight) {
+        if(!(weight > 0)) {
+            throw std::domain_error("Weights must be positive");
+        }
+        if(find_slot(start) == nullptr || find_slot(end) == nullptr) {
+            throw std::domain_error("Node does not exist");
+        }
+        append(slot(start).out_edges, end, weight);
+        append(slot(end).in_edges, start, weight);
+        edges.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    void create_link(const T &start, const T &end, double weight) {
+        if(!contains(start) || !contains(end)) {
+            throw std::domain_error("Node does not exist");
+        }
+        create_link(id(start), id(end), weight);
+    }
+
+    // The name of a node whose id came from create_node, id() or an edge.
+    const T &name(node_id node) const {
+        return *slot(node).name;
+    }
+
+    size_t edge_count() const {
+        return edges.load(std::memory_order_relaxed);
+    }
+
+    // A view of the graph as it is right now, for traversals:  see below.
+    concurrent_graph_view<T> view() const {
+        return concurrent_graph_view<T>(*this);
+    }
+
+    // Copies the current contents into a frozen_graph (whose ids match this
+    // graph's).  Node creation waits while this runs;  edges added during
+    // the copy may or may not make it in.
+    frozen_graph<T> freeze() const {
+        auto locks = std::vector<std::shared_lock<std::shared_mutex>>();
+        for(auto &s : shards) {
+            locks.emplace_back(s.mutex);
+        }
+        auto count = allocated.load(std::memory_order_acquire);
+        auto names = std::vector<T>();
+        auto frozen_edges = std::vector<frozen_edge>();
+        for(node_id u = 0; u < count; ++u) {
+            names.push_back(name(u));
+            walk(slot(u).out_edges, [&](node_id v, double weight) {
+                frozen_edges.push_back({u, v, weight});
+            });
+        }
+        return frozen_graph<T>(std::move(names), frozen_edges);
+    }
+};
+
+// The algorithms (dijkstra_workspace, delta_stepping, ...) size their
+// arrays by node_count() before they start.  On a graph that is still
+// growing, an edge added mid-traversal could lead to a node created after
+// that, past the end of those arrays.  So traversals go through a view,
+// which fixes the node count when it is taken and hides any edge leading
+// to a newer node.  Edges between older nodes still show up as they are
+// added, so a traversal sees at least everything that existed when the
+// view was taken.
+//
+// The view only holds a reference, so the graph must outlive it.
+template <class T>
+class concurrent_graph_view {
+private:
+    const concurrent_graph<T> &working_graph;
+    const node_id count;
+
+    friend concurrent_graph<T>;
+
+    explicit concurrent_graph_view(const concurrent_graph<T> &g) :
+    working_graph(g), count(g.constructed.load(std::memory_order_acquire)) {
+    }
+
+public:
+    node_id node_count() const {
+        return count;
+    }
+
+    const T &name(node_id node) const {
+        return working_graph.name(node);
+    }
+
+    node_id id(const T &name) const {
+        auto node = working_graph.id(name);
+        if(node >= count) {
+            throw std::logic_error("Unable to find the node");
+        }
+        return node;
+    }
+
+    template <class F>
+    void for_each_out_edge(node_id node, F &&f) const {
+        auto slot = working_graph.find_slot(node);
+        if(slot == nullptr) {
+            return;
+        }
+        concurrent_graph<T>::walk(slot->out_edges, [&](node_id next, double weight) {
+            if(next < count) {
+                f(next, weight);
+            }
+        });
+    }
+
+    template <class F>
+    void for_each_in_edge(node_id node, F &&f) const {
+        auto slot = working_graph.find_slot(node);
+        if(slot == nullptr) {
+            return;
+        }
+        concurrent_graph<T>::walk(slot->in_edges, [&](node_id next, double weight) {
+            if(next < count) {
+                f(next, weight);
+            }
+        });
+    }
+};
+
+void testConcurrentGraph();
+
+#endif //CONCURRENT_GRAPH_H
@@ -0,0 +1,55 @@
+#include "counting_allocator.hpp"
+
+#include <cassert>
+#include <iostream>
+#include <vector>
+
+#include "dijkstra_workspace.hpp"
+#include "graph_generators.hpp"
+
+void testCountingAllocator() {
+    std::cerr << "Initializing counting allocator tests" << std::endl;
+    auto counts = allocation_counts();
+    {
+        auto values = std::vector<int, counting_allocator<int>>(counting_allocator<int>(counts));
+        values.reserve(100);
+        assert(counts.allocations == 1 && counts.bytes_in_use == 100 * sizeof(int));
+        values.resize(1000);
+        assert(counts.allocations == 2 && counts.deallocations == 1);
+        assert(counts.bytes_in_use == 1000 * sizeof(int));
+        assert(counts.peak_bytes_in_use == 1100 * sizeof(int));
+    }
+    assert(counts.bytes_in_use == 0 && counts.deallocations == 2);
+
+    // Once a workspace has done a query, doing it again allocates nothing:
+    // that's the whole point of keeping the arrays between runs.
+    const int n = 1000;
+    auto generated = erdos_renyi_graph(n, 4);
+    use_whole_weights(generated, 10);
+    auto g = freeze<int>(generated);
+    counts = allocation_counts();
+    auto workspace = basic_dijkstra_workspace<counting_allocator<std::byte>>(counting_allocator<std::byte>(counts));
+    auto plain = dijkstra_workspace();
+    for(node_id source = 0; source < 10; ++source) {
+        workspace.run(g, source);
+        counts.reset();
+        workspace.run(g, source);
+        assert(counts.allocations == 0);
+        plain.run(g, source);
+        for(node_id u = 0; u < g.node_count(); ++u) {
+            assert(workspace.distance(u) == plain.distance(u));
+        }
+    }
+    assert(counts.bytes_in_use >= n * (sizeof(double) + sizeof(node_id) + sizeof(std::uint32_t)));
+
+    // And the same through a memory resource.
+    auto resource_counts = allocation_counts();
+    auto resource = counting_resource(resource_counts);
+    auto placed = pmr_dijkstra_workspace(&resource);
+    placed.run(g, 3);
+    plain.run(g, 3);
+    assert(resource_counts.allocations > 0);
+    for(node_id u = 0; u < g.node_count(); ++u) {
+        assert(placed.distance(u) == plain.distance(u));
+    }
+}
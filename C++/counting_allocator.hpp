@@ -0,0 +1,111 @@
+#ifndef COUNTING_ALLOCATOR_H
+#define COUNTING_ALLOCATOR_H
+
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+#include <memory_resource>
+
+// An allocator that counts what goes through it, for tests and capacity
+// planning:  instantiate a container (or a workspace, or a graph) with a
+// counting_allocator and its allocation_counts say how many allocations it
+// made and how many bytes it holds.  The obvious use is a regression test
+// like "a repeated query allocates nothing":
+//
+// auto counts = allocation_counts();
+// auto workspace = basic_dijkstra_workspace<counting_allocator<std::byte>>(counting_allocator<std::byte>(counts));
+// workspace.run(g, source);
+// counts.reset();
+// workspace.run(g, source);
+// assert(counts.allocations == 0);
+//
+// The memory itself comes from std::allocator.  The counts are plain
+// integers, so one allocation_counts shouldn't be shared between threads.
+
+struct allocation_counts {
+    size_t allocations = 0;
+    size_t deallocations = 0;
+    // Every byte ever allocated, whether or not it has been freed since.
+    size_t bytes_allocated = 0;
+    size_t bytes_in_use = 0;
+    size_t peak_bytes_in_use = 0;
+
+    // Starts counting afresh from here, leaving what is in use alone.
+    void reset() {
+        allocations = 0;
+        deallocations = 0;
+        bytes_allocated = 0;
+        peak_bytes_in_use = bytes_in_use;
+    }
+};
+
+template <class U>
+struct counting_allocator {
+    using value_type = U;
+
+    allocation_counts *counts;
+
+    explicit counting_allocator(allocation_counts &countsIn) : counts(&countsIn) {
+    }
+
+    template <class V>
+    counting_allocator(const counting_allocator<V> &other) : counts(other.counts) {
+    }
+
+    U *allocate(size_t count) {
+        auto result = std::allocator<U>().allocate(count);
+        counts->allocations++;
+        counts->bytes_allocated += count * sizeof(U);
+        counts->bytes_in_use += count * sizeof(U);
+        counts->peak_bytes_in_use = std::max(counts->peak_bytes_in_use, counts->bytes_in_use);
+        return result;
+    }
+
+    void deallocate(U *pointer, size_t count) {
+        counts->deallocations++;
+        counts->bytes_in_use -= count * sizeof(U);
+        std::allocator<U>().deallocate(pointer, count);
+    }
+
+    template <class V>
+    bool operator==(const counting_allocator<V> &other) const {
+        return counts == other.counts;
+    }
+};
+
+// The same counting, as a std::pmr::memory_resource (for a graph<T>, or
+// anything else that takes one), passing the memory on to upstream.
+class counting_resource : public std::pmr::memory_resource {
+private:
+    allocation_counts *counts;
+    std::pmr::memory_resource *upstream;
+
+    void *do_allocate(size_t bytes, size_t alignment) override {
+        auto result = upstream->allocate(bytes, alignment);
+        counts->allocations++;
+        counts->bytes_allocated += bytes;
+        counts->bytes_in_use += bytes;
+        counts->peak_bytes_in_use = std::max(counts->peak_bytes_in_use, counts->bytes_in_use);
+        return result;
+    }
+
+    void do_deallocate(void *pointer, size_t bytes, size_t alignment) override {
+        counts->deallocations++;
+        counts->bytes_in_use -= bytes;
+        upstream->deallocate(pointer, bytes, alignment);
+    }
+
+    bool do_is_equal(const std::pmr::memory_resource &other) const noexcept override {
+        return this == &other;
+    }
+
+public:
+    explicit counting_resource(allocation_counts &countsIn,
+                               std::pmr::memory_resource *upstreamIn = std::pmr::get_default_resource()) :
+    counts(&countsIn), upstream(upstreamIn) {
+    }
+};
+
+void testCountingAllocator();
+
+#endif //COUNTING_ALLOCATOR_H
@@ -0,0 +1,79 @@
+#include "delta_stepping.hpp"
+
+#include <cassert>
+
+#include "graph_generators.hpp"
+
+// Delta stepping has to agree exactly with dijkstra_traversal, so the test
+// builds random graphs, runs both, and compares every distance.  We try a
+// range of deltas (from "basically Dijkstra" to "basically Bellman-Ford")
+// and a pool with more threads than this machine may have cores, so that
+// the threads really do interleave.
+
+void testDeltaStepping() {
+    std::cerr << "Initializing delta stepping tests" << std::endl;
+    auto pool = thread_pool(4);
+    for(auto k = 0; k < 10; ++k) {
+        auto g = build_graph<int>(erdos_renyi_graph(200, 4, k));
+
+        auto expected = std::unordered_map<int, double>();
+        for(auto step : dijkstra_traversal<int>(g, 0)) {
+            expected[step->current->name] = step->distance;
+        }
+
+        auto frozen = frozen_graph<int>(*g);
+        auto source = frozen.id(0);
+        for(auto delta : {0.5, 10.0, 30.0, 1000.0, default_delta(frozen)}) {
+            auto result = delta_stepping(frozen, source, pool, delta);
+            for(node_id i = 0; i < frozen.node_count(); ++i) {
+                auto name = frozen.name(i);
+                if(expected.contains(name)) {
+                    assert(result.distance[i] == expected[name]);
+                } else {
+                    assert(result.distance[i] == HUGE_VAL);
+                }
+                if(i == source || result.distance[i] == HUGE_VAL) {
+                    assert(result.parent[i] == no_node);
+                } else {
+                    auto parent = result.parent[i];
+                    assert(parent != no_node);
+                    auto found = false;
+                    frozen.for_each_out_edge(parent, [&](node_id next, double w) {
+                        if(next == i && result.distance[parent] + w == result.distance[i]) {
+                            found = true;
+                        }
+                    });
+                    assert(found);
+                }
+            }
+        }
+    }
+
+    // And the ring from testGraph, where every distance is a hop count.
+    auto ring = std::make_shared<graph<int>>();
+    for(auto i = 0; i < 10; ++i) {
+        ring->create_node(i);
+    }
+    for(auto i = 0; i < 10; ++i) {
+        ring->create_link(i, (i + 1) % 10, 1.0);
+    }
+    auto frozen = frozen_graph<int>(*ring);
+    auto result = delta_stepping(frozen, frozen.id(0), pool);
+    for(auto i = 0; i < 10; ++i) {
+        assert(result.distance[frozen.id(i)] == double(i));
+        if(i != 0) {
+            assert(frozen.name(result.parent[frozen.id(i)]) == i - 1);
+        }
+    }
+
+    // A delta so small that bucket numbers wouldn't fit in a size_t is
+    // refused, but one that only makes a lot of (sparse) buckets is fine.
+    auto failed = false;
+    try {
+        delta_stepping(frozen, frozen.id(0), pool, 1e-30);
+    } catch(std::domain_error &) {
+        failed = true;
+    }
+    assert(failed);
+    assert(delta_stepping(frozen, frozen.id(0), pool, 1e-9).distance == result.distance);
+}
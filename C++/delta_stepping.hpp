@@ -0,0 +1,225 @@
+#ifndef DELTA_STEPPING_H
+#define DELTA_STEPPING_H
+
+#include <atomic>
+#include <cmath>
+#include <map>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include "frozen_graph.hpp"
+#include "thread_pool.hpp"
+
+// Delta stepping (Meyer and Sanders) is a parallel single source shortest
+// path algorithm.  Dijkstra's algorithm is inherently sequential: it settles
+// exactly one node at a time, the closest one remaining.  Delta stepping
+// instead groups the tentative distances into buckets of width delta, and
+// processes a whole bucket at once.
+//
+// Within a bucket the edges are split in two.  A "light" edge (weight <=
+// delta) can lead to another node in the same bucket, so the bucket is
+// relaxed over its light edges repeatedly until it stops changing.  A
+// "heavy" edge (weight > delta) can never land back in the current bucket,
+// so heavy edges only need relaxing once, after the bucket is finished.
+// Every one of those relaxation rounds is a parallel loop over the nodes
+// involved.
+//
+// The choice of delta is a tradeoff.  A tiny delta makes every bucket hold
+// about one node, which is just a slow Dijkstra.  A huge delta puts
+// everything in one bucket, which is just a parallel Bellman-Ford that
+// does lots of wasted re-relaxation.
+//
+// The distances are exactly the ones dijkstra_traversal produces:  both
+// compute, for every node, the minimum over all paths of the path weights
+// summed in path order, so even the floating point rounding agrees.  When
+// there are several shortest paths to a node, the parent reported is the
+// lowest numbered node that ends one of them, so the result is the same no
+// matter how the threads interleave.
+//
+// This works on any graph type with node_count() and
+// for_each_out_edge(node, f), such as frozen_graph.
+
+struct sssp_result {
+    std::vector<double> distance;
+    std::vector<node_id> parent;
+};
+
+// The heaviest edge weight (0 with no edges), and the number of edges.
+template <class Graph>
+std::pair<double, size_t> max_edge_weight(const Graph &g) {
+    double max_weight = 0;
+    size_t edges = 0;
+    for(node_id u = 0; u < g.node_count(); ++u) {
+        g.for_each_out_edge(u, [&](node_id, double weight) {
+            max_weight = std::max(max_weight, weight);
+            edges++;
+        });
+    }
+    return {max_weight, edges};
+}
+
+// A default delta:  the heaviest edge divided by the average degree, which
+// is the value Meyer and Sanders suggest for random edge weights.
+template <class Graph>
+double default_delta(const Graph &g) {
+    auto [max_weight, edges] = max_edge_weight(g);
+    if(edges == 0) {
+        return 1.0;
+    }
+    return max_weight * g.node_count() / double(edges);
+}
+
+template <class Graph>
+sssp_result delta_stepping(const Graph &g, node_id source, thread_pool &pool, double delta) {
+    if(!(delta > 0)) {
+        throw std::domain_error("Delta must be positive");
+    }
+    auto n = g.node_count();
+    if(source >= n) {
+        throw std::logic_error("Unable to find the node");
+    }
+    // Bucket numbers are distance / delta as a size_t, and no shortest path
+    // is longer than n - 1 of the heaviest edge, so a delta small enough for
+    // that to overflow (bucket + 1 included) is refused rather than cast.
+    auto longest = std::max(1.0, double(n - 1)) * max_edge_weight(g).first;
+    if(!(longest / delta < 0x1p62)) {
+        throw std::domain_error("Delta too small for these edge weights");
+    }
+
+    auto dist = std::vector<std::atomic<double>>(n);
+    for(auto &d : dist) {
+        d.store(HUGE_VAL, std::memory_order_relaxed);
+    }
+
+    // The buckets are kept sparse in a map, since with a small delta the
+    // bucket numbers can get very large while most buckets stay empty.
+    // A node can sit in several buckets at once (every time its distance
+    // drops it is added again);  stale copies are skipped when popped.
+    auto buckets = std::map<size_t, std::vector<node_id>>();
+    auto bucket_of = [&](double d) { return static_cast<size_t>(d / delta); };
+
+    // Each worker collects the nodes it improved in its own list, and they
+    // are merged into the buckets once the parallel loop is over.
+    auto improved = std::vector<std::vector<node_id>>(pool.size());
+    auto relax = [&](unsigned worker, node_id node, double distance) {
+        auto current = dist[node].load(std::memory_order_relaxed);
+        while(distance < current) {
+            if(dist[node].compare_exchange_weak(current, distance, std::memory_order_relaxed)) {
+                improved[worker].push_back(node);
+                return;
+            }
+        }
+    };
+    auto merge_improved = [&]() {
+        for(auto &list : improved) {
+            for(auto node : list) {
+                buckets[bucket_of(dist[node].load(std::memory_order_relaxed))].push_back(node);
+            }
+            list.clear();
+        }
+    };
+
+    // Marks used to drop duplicates:  queued[v] == round means v is already
+    // in this round's frontier, settled_in[v] == bucket + 1 means v is
+    // already on this bucket's settled list.
+    auto queued = std::vector<size_t>(n, 0);
+    auto settled_in = std::vector<size_t>(n, 0);
+    size_t round = 0;
+
+    dist[source].store(0, std::memory_order_relaxed);
+    buckets[0].push_back(source);
+
+    auto frontier = std::vector<node_id>();
+    auto settled = std::vector<node_id>();
+    while(!buckets.empty()) {
+        auto bucket = buckets.begin()->first;
+        settled.clear();
+
+        // Light edges, over and over until nothing new lands in this bucket.
+        while(buckets.contains(bucket)) {
+            auto candidates = std::move(buckets[bucket]);
+            buckets.erase(bucket);
+            frontier.clear();
+            ++round;
+            for(auto node : candidates) {
+                if(queued[node] == round ||
+                   bucket_of(dist[node].load(std::memory_order_relaxed)) != bucket) {
+                    continue;
+                }
+                queued[node] = round;
+                frontier.push_back(node);
+                if(settled_in[node] != bucket + 1) {
+                    settled_in[node] = bucket + 1;
+                    settled.push_back(node);
+                }
+            }
+            pool.parallel_for(frontier.size(), [&](unsigned worker, size_t i) {
+                auto node = frontier[i];
+                auto base = dist[node].load(std::memory_order_relaxed);
+                g.for_each_out_edge(node, [&](node_id next, double weight) {
+                    if(weight <= delta) {
+                        relax(worker, next, base + weight);
+                    }
+                });
+            });
+            merge_improved();
+        }
+
+        // And the heavy edges, once, now that this bucket's distances are final.
+        pool.parallel_for(settled.size(), [&](unsigned worker, size_t i) {
+            auto node = settled[i];
+            auto base = dist[node].load(std::memory_order_relaxed);
+            g.for_each_out_edge(node, [&](node_id next, double weight) {
+                if(weight > delta) {
+                    relax(worker, next, base + weight);
+                }
+            });
+        });
+        merge_improved();
+    }
+
+    auto result = sssp_result();
+    result.distance.resize(n);
+    for(node_id i = 0; i < n; ++i) {
+        result.distance[i] = dist[i].load(std::memory_order_relaxed);
+    }
+
+    // Parents are picked after the fact:  any node u with an edge u->v where
+    // distance[u] + weight == distance[v] ends a shortest path to v, and we
+    // keep the lowest numbered one.
+    auto parent = std::vector<std::atomic<node_id>>(n);
+    for(auto &p : parent) {
+        p.store(no_node, std::memory_order_relaxed);
+    }
+    pool.parallel_for(n, [&](unsigned, size_t i) {
+        auto node = static_cast<node_id>(i);
+        auto base = result.distance[node];
+        if(base == HUGE_VAL) {
+            return;
+        }
+        g.for_each_out_edge(node, [&](node_id next, double weight) {
+            if(next == source || base + weight != result.distance[next]) {
+                return;
+            }
+            auto current = parent[next].load(std::memory_order_relaxed);
+            while(node < current &&
+                  !parent[next].compare_exchange_weak(current, node, std::memory_order_relaxed)) {
+            }
+        });
+    }, 1024);
+    result.parent.resize(n);
+    for(node_id i = 0; i < n; ++i) {
+        result.parent[i] = parent[i].load(std::memory_order_relaxed);
+    }
+    return result;
+}
+
+template <class Graph>
+sssp_result delta_stepping(const Graph &g, node_id source, thread_pool &pool) {
+    return delta_stepping(g, source, pool, default_delta(g));
+}
+
+void testDeltaStepping();
+
+#endif //DELTA_STEPPING_H
@@ -0,0 +1,183 @@
+#include "dfs.hpp"
+
+#include <cassert>
+#include <iostream>
+#include <random>
+
+#include "counting_allocator.hpp"
+#include "graph_generators.hpp"
+
+// The DFS traversal on hand built graphs where the order is known, and on
+// a chain far too deep to recurse down.  Then the DAG workspace on random
+// DAGs:  orders that respect every edge, shortest paths that match
+// Dijkstra, longest paths that match Bellman-Ford (with the comparison
+// flipped), and real cycles once a back edge is added.
+
+static_assert(std::input_iterator<dfs_traversal_iterator<int>>);
+static_assert(std::ranges::view<dfs_traversal<int>>);
+
+static std::vector<double> longest_by_bellman_ford(const frozen_graph<int> &g, node_id source) {
+    auto distance = std::vector<double>(g.node_count(), -HUGE_VAL);
+    distance[source] = 0;
+    for(node_id round = 0; round < g.node_count(); ++round) {
+        for(node_id u = 0; u < g.node_count(); ++u) {
+            if(distance[u] == -HUGE_VAL) {
+                continue;
+            }
+            g.for_each_out_edge(u, [&](node_id v, double w) {
+                distance[v] = std::max(distance[v], distance[u] + w);
+            });
+        }
+    }
+    return distance;
+}
+
+void testDfs() {
+    std::cerr << "Initializing DFS tests" << std::endl;
+
+    // 0 -> 1 -> {3, 4}, 0 -> 2, 2 -> 4, and 5 unreachable.  Edges are
+    // followed in the order they were made.
+    auto tree = std::make_shared<graph<int>>();
+    for(auto i = 0; i < 6; ++i) {
+        tree->create_node(i);
+    }
+    tree->create_link(0, 1, 1);
+    tree->create_link(0, 2, 1);
+    tree->create_link(1, 3, 1);
+    tree->create_link(1, 4, 1);
+    tree->create_link(2, 4, 1);
+    tree->create_link(4, 0, 1);
+    auto expected = std::vector<std::pair<int, size_t>> {{0, 0}, {1, 1}, {3, 2}, {4, 2}, {2, 1}};
+    size_t i = 0;
+    for(auto &step : dfs_traversal<int>(tree, 0)) {
+        assert(i < expected.size());
+        assert(step.current->name == expected[i].first && step.depth == expected[i].second);
+        assert((step.previous == nullptr) == (i == 0));
+        i++;
+    }
+    assert(i == expected.size());
+    // Counted:  each of the 6 edges out of the 5 reached nodes looked at
+    // once, and the stack at its deepest holding 0, 1 and 3.
+    auto stats = traversal_stats();
+    for([[maybe_unused]] auto &step : dfs_traversal<int, true>(tree, 0, stats)) {
+    }
+    assert(stats.nodes_settled == 5 && stats.queue_pushes == 5 && stats.queue_pops == 5);
+    assert(stats.edges_relaxed == 6 && stats.peak_frontier == 3);
+
+    const int length = 200000;
+    auto chain = std::make_shared<graph<int>>();
+    for(auto k = 0; k < length; ++k) {
+        chain->create_node(k);
+    }
+    for(auto k = 0; k + 1 < length; ++k) {
+        chain->create_link(k, k + 1, 1);
+    }
+    i = 0;
+    for(auto &step : dfs_traversal<int>(chain, 0)) {
+        assert(step.current->name == int(i) && step.depth == i);
+        i++;
+    }
+    assert(i == length);
+
+    auto rng = std::default_random_engine {};
+    const int n = 200;
+    auto workspace = dag_workspace();
+    auto dijkstra = dijkstra_workspace();
+    for(auto trial = 0; trial < 10; ++trial) {
+        // Edges only ever go forwards in a random permutation, so it's a DAG.
+        auto rank = std::vector<node_id>(n);
+        for(auto k = 0; k < n; ++k) {
+            rank[k] = k;
+        }
+        std::shuffle(rank.begin(), rank.end(), rng);
+        auto generated = erdos_renyi_graph(n, 3, trial);
+        use_whole_weights(generated, 10);
+        for(auto &e : generated.edges) {
+            if(rank[e.start] > rank[e.end]) {
+                std::swap(e.start, e.end);
+            }
+        }
+        remove_duplicate_edges(generated.edges);
+        auto &edges = generated.edges;
+        auto dag = freeze<int>(generated);
+        assert(workspace.sort(dag));
+        auto order = workspace.order();
+        assert(order.size() == size_t(n));
+        auto position = std::vector<size_t>(n);
+        for(size_t k = 0; k < order.size(); ++k) {
+            position[order[k]] = k;
+        }
+        for(auto &e : edges) {
+            assert(position[e.start] < position[e.end]);
+        }
+        for(node_id source = 0; source < 5; ++source) {
+            workspace.shortest_paths(dag, source);
+            dijkstra.run(dag, source);
+            for(node_id u = 0; u < n; ++u) {
+                assert(workspace.distance(u) == dijkstra.distance(u));
+            }
+            // Counted, every reached node goes through once, with all its
+            // out edges.
+            stats.clear();
+            workspace.shortest_paths(dag, source, stats);
+            auto out_of_reached = size_t(0);
+            for(node_id u = 0; u < n; ++u) {
+                out_of_reached += workspace.distance(u) != HUGE_VAL ? dag.out_degree(u) : 0;
+            }
+            assert(stats.nodes_settled == dijkstra.settled_count());
+            assert(stats.queue_pushes == stats.nodes_settled && stats.queue_pops == stats.nodes_settled);
+            assert(stats.edges_relaxed == out_of_reached);
+            workspace.longest_paths(dag, source);
+            auto longest = longest_by_bellman_ford(dag, source);
+            auto path = std::vector<node_id>();
+            for(node_id u = 0; u < n; ++u) {
+                if(longest[u] == -HUGE_VAL) {
+                    assert(workspace.distance(u) == HUGE_VAL && workspace.parent(u) == no_node);
+                    continue;
+                }
+                assert(workspace.distance(u) == longest[u]);
+                workspace.path_to(u, path);
+                assert(path.front() == source && path.back() == u);
+            }
+        }
+
+        // Reversing any edge's direction as well closes a cycle.
+        edges.push_back({edges[trial].end, edges[trial].start, 1.0});
+        auto cyclic = freeze<int>(generated);
+        assert(!workspace.sort(cyclic));
+        assert(workspace.order().empty());
+        auto cycle = workspace.cycle();
+        assert(!cycle.empty());
+        for(size_t k = 0; k < cycle.size(); ++k) {
+            auto next = cycle[(k + 1) % cycle.size()];
+            auto found = false;
+            cyclic.for_each_out_edge(cycle[k], [&](node_id v, double) { found = found || v == next; });
+            assert(found);
+        }
+        auto threw = false;
+        try {
+            workspace.shortest_paths(cyclic, 0);
+        } catch(std::logic_error &) {
+            threw = true;
+        }
+        assert(threw);
+    }
+
+    // A self loop is a cycle of one.
+    auto loop = frozen_graph<int>(std::vector<int> {0, 1}, std::vector<frozen_edge> {{0, 1, 1}, {1, 1, 1}});
+    assert(!workspace.sort(loop));
+    assert(workspace.cycle().size() == 1 && workspace.cycle()[0] == 1);
+
+    // Once sorted, path queries allocate nothing.
+    auto counts = allocation_counts();
+    auto counted = basic_dag_workspace<counting_allocator<std::byte>>(counting_allocator<std::byte>(counts));
+    auto line = frozen_graph<int>(std::vector<int> {0, 1, 2}, std::vector<frozen_edge> {{0, 1, 1}, {1, 2, 2}, {0, 2, 5}});
+    assert(counted.sort(line));
+    counted.longest_paths(line, 0);
+    counts.reset();
+    counted.shortest_paths(line, 0);
+    assert(counted.distance(2) == 3);
+    counted.longest_paths(line, 0);
+    assert(counted.distance(2) == 5 && counted.parent(2) == 0);
+    assert(counts.allocations == 0);
+}
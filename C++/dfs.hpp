@@ -0,0 +1,347 @@
+#ifndef DFS_H
+#define DFS_H
+
+#include <cmath>
+#include <cstdint>
+#include <functional>
+#include <memory_resource>
+#include <span>
+#include <unordered_set>
+#include <vector>
+
+#include "dijkstra_workspace.hpp"
+#include "graph.hpp"
+#include "traversal_stats.hpp"
+
+// Depth first search, and the things it's good for on DAGs.
+//
+// dfs_traversal is a lazy range over a graph<T>, like dijkstra_traversal
+// and bfs_traversal, handing out the nodes in depth first preorder.  It
+// keeps an explicit stack of (node, next edge to look at) rather than
+// recursing, so a long chain (a deep dependency graph, say) can't overflow
+// the call stack, and the stack only ever holds the current path.
+//
+// dag_workspace does the same over the dense graph types, for dependency
+// and pipeline graphs:  a topological sort that reports a cycle if there
+// is one, then shortest or longest paths from a source in linear time,
+// by relaxing each node's out edges in topological order.  When a node's
+// turn comes every edge into it has already been relaxed, so its distance
+// is final:  no priority queue needed, which also makes longest paths
+// (which Dijkstra can't do) just as easy.  Like dijkstra_workspace it
+// keeps its arrays between runs, with the same stamped labels, so the
+// same distance(), parent() and path_to().
+//
+// Both count what they do into a traversal_stats the same way too
+// (dfs_traversal<T, true>, or the path methods given one).  For
+// dfs_traversal the frontier is the stack, so the peak is the deepest the
+// search went.  For dag_workspace a node is pushed when it is first
+// reached and popped when its turn in the order comes, and a better
+// distance for a node already reached counts as a decrease-key.
+
+// One step of a dfs_traversal:  the node reached, how deep it is in the
+// search tree, and the node it was reached from (null for the start).
+template <class T>
+struct dfs_step {
+    std::shared_ptr<graph_node<T>> current;
+    size_t depth = 0;
+    std::shared_ptr<graph_node<T>> previous = nullptr;
+};
+
+template <class T, bool Instrumented = false> class dfs_traversal;
+
+template <class T, bool Instrumented>
+class dfs_traversal_iterator {
+    friend dfs_traversal<T, Instrumented>;
+public:
+    using iterator_concept = std::input_iterator_tag;
+    using value_type = dfs_step<T>;
+    using difference_type = std::ptrdiff_t;
+
+private:
+    struct frame {
+        graph_node<T> *node;
+        size_t next_edge;
+    };
+
+    std::shared_ptr<const graph<T>> working_graph = nullptr;
+    std::pmr::vector<frame> stack;
+    std::pmr::unordered_set<const graph_node<T> *> seen;
+    dfs_step<T> current;
+    [[no_unique_address]] traversal_recorder<Instrumented> recorder;
+
+    dfs_traversal_iterator(std::shared_ptr<const graph<T>> graph_ptr, T start,
+                           traversal_recorder<Instrumented> recorderIn, std::pmr::memory_resource *resource) :
+    working_graph(graph_ptr), stack(resource), seen(resource), recorder(recorderIn) {
+        auto itr = working_graph->nodes.find(start);
+        if(itr == working_graph->nodes.end()) {
+            throw std::logic_error("Unable to find the node");
+        }
+        auto started = recorder.now();
+        seen.insert(itr->second.get());
+        stack.push_back({itr->second.get(), 0});
+        current = {itr->second, 0, nullptr};
+        recorder.pushed();
+        recorder.settled();
+        recorder.add_setup_time(started);
+    }
+
+    // Finds the next unseen node:  carry on through the edges of the node
+    // on top of the stack, and once it has none left go back up a level.
+    void iter() {
+        auto started = recorder.now();
+        search();
+        recorder.add_search_time(started);
+    }
+
+    void search() {
+        while(!stack.empty()) {
+            auto &top = stack.back();
+            auto &edges = top.node->out_edges;
+            while(top.next_edge < edges.size()) {
+                auto &edge = edges[top.next_edge++];
+                recorder.relaxed();
+                if(seen.insert(edge->end.get()).second) {
+                    current = {edge->end, stack.size(), edge->start};
+                    stack.push_back({edge->end.get(), 0});
+                    recorder.pushed();
+                    recorder.settled();
+                    return;
+                }
+            }
+            stack.pop_back();
+            recorder.popped();
+        }
+        current = {};
+    }
+
+public:
+    dfs_traversal_iterator() = default;
+
+    dfs_traversal_iterator &operator++() {
+        iter();
+        return *this;
+    }
+
+    void operator++(int) {
+        iter();
+    }
+
+    const dfs_step<T> &operator*() const {
+        return current;
+    }
+
+    bool operator==(dijkstra_traversal_sentinel) const {
+        return current.current == nullptr;
+    }
+};
+
+template <class T, bool Instrumented>
+class dfs_traversal : public std::ranges::view_interface<dfs_traversal<T, Instrumented>> {
+public:
+    std::shared_ptr<const graph<T>> working_graph;
+    T start;
+    [[no_unique_address]] traversal_recorder<Instrumented> recorder;
+    std::pmr::memory_resource *resource;
+
+    dfs_traversal(std::shared_ptr<const graph<T>> g, T s,
+                  std::pmr::memory_resource *resourceIn = std::pmr::get_default_resource())
+    requires (!Instrumented) : working_graph(g), start(s), resource(resourceIn) {
+    }
+
+    dfs_traversal(std::shared_ptr<const graph<T>> g, T s, traversal_stats &stats,
+                  std::pmr::memory_resource *resourceIn = std::pmr::get_default_resource())
+    requires Instrumented : working_graph(g), start(s), recorder(stats), resource(resourceIn) {
+    }
+
+    dfs_traversal_iterator<T, Instrumented> begin() const {
+        return dfs_traversal_iterator<T, Instrumented>(working_graph, start, recorder, resource);
+    }
+
+    dijkstra_traversal_sentinel end() const {
+        return {};
+    }
+};
+
+// sort(g) puts the nodes in topological order (every edge goes from an
+// earlier node to a later one), or finds a cycle.  After a successful
+// sort, shortest_paths and longest_paths can be run from as many sources
+// as wanted, each in time linear in the part of the graph after the
+// source.  Not thread safe;  give each thread its own.
+template <class Allocator = std::allocator<std::byte>>
+class basic_dag_workspace : public basic_path_labels<Allocator> {
+private:
+    using labels = basic_path_labels<Allocator>;
+    template <class U>
+    using vector = typename labels::template vector<U>;
+
+    // The search pushes every out edge of a node at once (the graphs only
+    // offer for_each_out_edge, which can't be paused half way through a
+    // node), along with the node that pushed it.  A node is "open" from
+    // when the search first enters it until everything pushed above it
+    // has been dealt with, which is exactly while it is on the current
+    // search path:  so meeting an edge into an open node means a cycle.
+    struct stack_entry {
+        node_id node;
+        node_id from;
+    };
+
+    // no_node marks the end of a node:  everything above it is done.
+    static constexpr node_id close_marker = no_node;
+
+    enum : std::uint8_t { unseen = 0, open = 1, closed = 2 };
+
+    vector<stack_entry> stack;
+    vector<std::uint8_t> states;
+    vector<node_id> search_parents;
+    vector<node_id> sorted;
+    vector<node_id> positions;
+    vector<node_id> found_cycle;
+    bool is_sorted = false;
+
+    // Walks the search path back from the node that found the edge to the
+    // open node it led to, which is the cycle.
+    void record_cycle(node_id from, node_id to) {
+        found_cycle.clear();
+        for(auto node = from; node != to; node = search_parents[node]) {
+            found_cycle.push_back(node);
+        }
+        found_cycle.push_back(to);
+        std::reverse(found_cycle.begin(), found_cycle.end());
+    }
+
+    template <class Graph, class Better, bool Instrumented>
+    void relax_in_order(const Graph &g, node_id source, Better &&better, traversal_recorder<Instrumented> recorder) {
+        if(!is_sorted || sorted.size() != g.node_count()) {
+            throw std::logic_error("Graph must be sorted first");
+        }
+        if(source >= g.node_count()) {
+            throw std::logic_error("Unable to find the node");
+        }
+        auto started = recorder.now();
+        this->start_labels(g.node_count());
+        this->label(source, 0, no_node);
+        recorder.pushed();
+        recorder.add_setup_time(started);
+        started = recorder.now();
+        for(auto i = positions[source]; i < sorted.size(); ++i) {
+            auto u = sorted[i];
+            if(!this->labelled(u)) {
+                continue;
+            }
+            recorder.popped();
+            recorder.settled();
+            auto distance = this->distances[u];
+            g.for_each_out_edge(u, [&](node_id next, double weight) {
+                recorder.relaxed();
+                if(!this->labelled(next)) {
+                    recorder.pushed();
+                    this->label(next, distance + weight, u);
+                } else if(better(distance + weight, this->distances[next])) {
+                    recorder.decreased_key();
+                    this->label(next, distance + weight, u);
+                }
+            });
+        }
+        recorder.add_search_time(started);
+    }
+
+public:
+    basic_dag_workspace() = default;
+
+    explicit basic_dag_workspace(const Allocator &allocator) :
+    labels(allocator), stack(allocator), states(allocator), search_parents(allocator),
+    sorted(allocator), positions(allocator), found_cycle(allocator) {
+    }
+
+    // Returns true if g is a DAG, leaving the order in order();  otherwise
+    // false, leaving one cycle in cycle().
+    template <class Graph>
+    bool sort(const Graph &g) {
+        auto n = g.node_count();
+        is_sorted = false;
+        found_cycle.clear();
+        sorted.clear();
+        states.assign(n, unseen);
+        search_parents.resize(n);
+        positions.resize(n);
+        // Nodes are added as they close, which is reverse topological
+        // order:  a node only closes after everything it leads to has.
+        for(node_id root = 0; root < n; ++root) {
+            if(states[root] != unseen) {
+                continue;
+            }
+            stack.clear();
+            stack.push_back({root, no_node});
+            while(!stack.empty()) {
+                auto entry = stack.back();
+                stack.pop_back();
+                if(entry.node == close_marker) {
+                    states[entry.from] = closed;
+                    sorted.push_back(entry.from);
+                    continue;
+                }
+                if(states[entry.node] == open) {
+                    record_cycle(entry.from, entry.node);
+                    return false;
+                }
+                if(states[entry.node] == closed) {
+                    continue;
+                }
+                states[entry.node] = open;
+                search_parents[entry.node] = entry.from;
+                stack.push_back({close_marker, entry.node});
+                g.for_each_out_edge(entry.node, [&](node_id next, double) {
+                    if(states[next] != closed) {
+                        stack.push_back({next, entry.node});
+                    }
+                });
+            }
+        }
+        std::reverse(sorted.begin(), sorted.end());
+        for(node_id i = 0; i < n; ++i) {
+            positions[sorted[i]] = i;
+        }
+        is_sorted = true;
+        return true;
+    }
+
+    // The order from the last successful sort.
+    std::span<const node_id> order() const {
+        return is_sorted ? std::span<const node_id>(sorted.data(), sorted.size()) : std::span<const node_id>();
+    }
+
+    // From the last failed sort:  nodes c0, c1, ... ck with an edge from
+    // each to the next, and from ck back to c0.
+    std::span<const node_id> cycle() const {
+        return {found_cycle.data(), found_cycle.size()};
+    }
+
+    // Shortest and longest paths from source, for distance(), parent() and
+    // path_to().  Both need g sorted first (and unchanged since).
+    template <class Graph>
+    void shortest_paths(const Graph &g, node_id source) {
+        relax_in_order(g, source, std::less<double>(), traversal_recorder<false>());
+    }
+
+    template <class Graph>
+    void longest_paths(const Graph &g, node_id source) {
+        relax_in_order(g, source, std::greater<double>(), traversal_recorder<false>());
+    }
+
+    // The same, adding what the run did to stats.
+    template <class Graph>
+    void shortest_paths(const Graph &g, node_id source, traversal_stats &stats) {
+        relax_in_order(g, source, std::less<double>(), traversal_recorder<true>(stats));
+    }
+
+    template <class Graph>
+    void longest_paths(const Graph &g, node_id source, traversal_stats &stats) {
+        relax_in_order(g, source, std::greater<double>(), traversal_recorder<true>(stats));
+    }
+};
+
+using dag_workspace = basic_dag_workspace<>;
+
+void testDfs();
+
+#endif //DFS_H
@@ -0,0 +1,233 @@
+#ifndef DIJKSTRA_WORKSPACE_H
+#define DIJKSTRA_WORKSPACE_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <memory>
+#include <memory_resource>
+#include <vector>
+
+#include "frozen_graph.hpp"
+#include "traversal_stats.hpp"
+
+// A heap based Dijkstra over dense node ids, built to be run over and over.
+//
+// The scratch space a Dijkstra run needs (a distance and a parent per node,
+// plus the priority queue) is the expensive part of a short query:  for a
+// query that only explores a few hundred nodes, allocating and clearing
+// arrays sized for the whole graph would cost far more than the search
+// itself.  So the workspace keeps its arrays between runs, and instead of
+// clearing them it keeps a "stamp" per node:  a node's entries are only
+// valid if its stamp matches the current run's number, so starting a new
+// run is just incrementing that number.
+//
+// The priority queue is a binary heap of (distance, node) pairs with lazy
+// deletion:  rather than doing a decrease-key when a distance drops, we
+// push a new entry and skip the stale one when it is popped.
+//
+// Passing run a traversal_stats fills it in with what the run did (see
+// traversal_stats.hpp);  without one the counting isn't compiled in at all.
+//
+// The arrays come from Allocator (rebound as needed), which is
+// std::allocator for the plain dijkstra_workspace;  instantiating it with
+// a counting_allocator is how the tests check that a repeated query
+// allocates nothing, and pmr_dijkstra_workspace takes its memory from a
+// std::pmr::memory_resource.
+//
+// A workspace is not thread safe;  give each thread its own.
+
+// What a single source search leaves behind:  a distance and a parent per
+// node, valid only where the node's stamp matches the current run.  Shared
+// with the other workspaces that label nodes the same way (see
+// dag_workspace in dfs.hpp).
+template <class Allocator>
+class basic_path_labels {
+protected:
+    template <class U>
+    using vector = std::vector<U, typename std::allocator_traits<Allocator>::template rebind_alloc<U>>;
+
+    vector<double> distances;
+    vector<node_id> parents;
+    vector<std::uint32_t> stamps;
+    std::uint32_t current_stamp = 0;
+
+    basic_path_labels() = default;
+
+    explicit basic_path_labels(const Allocator &allocator) :
+    distances(allocator), parents(allocator), stamps(allocator) {
+    }
+
+    // Makes room for n nodes, and forgets every label from the last run.
+    void start_labels(node_id n) {
+        if(distances.size() < n) {
+            distances.resize(n);
+            parents.resize(n);
+            stamps.resize(n, 0);
+        }
+        if(++current_stamp == 0) {
+            // After four billion runs the stamps wrap around, and an old
+            // stamp could be mistaken for the current one.
+            std::fill(stamps.begin(), stamps.end(), 0);
+            current_stamp = 1;
+        }
+    }
+
+    bool labelled(node_id node) const {
+        return stamps[node] == current_stamp;
+    }
+
+    void label(node_id node, double distance, node_id parent) {
+        stamps[node] = current_stamp;
+        distances[node] = distance;
+        parents[node] = parent;
+    }
+
+public:
+    // The distance found to node by the last run, or +infinity if the run
+    // never reached it.
+    double distance(node_id node) const {
+        if(node >= stamps.size() || stamps[node] != current_stamp) {
+            return HUGE_VAL;
+        }
+        return distances[node];
+    }
+
+    node_id parent(node_id node) const {
+        if(node >= stamps.size() || stamps[node] != current_stamp) {
+            return no_node;
+        }
+        return parents[node];
+    }
+
+    // Writes the path from the last run's source to target into path,
+    // reusing path's storage.  Leaves path empty if target wasn't reached.
+    void path_to(node_id target, std::vector<node_id> &path) const {
+        path.clear();
+        if(distance(target) == HUGE_VAL) {
+            return;
+        }
+        for(auto node = target; node != no_node; node = parents[node]) {
+            path.push_back(node);
+        }
+        std::reverse(path.begin(), path.end());
+    }
+};
+
+template <class Allocator = std::allocator<std::byte>>
+class basic_dijkstra_workspace : public basic_path_labels<Allocator> {
+private:
+    using labels = basic_path_labels<Allocator>;
+    template <class U>
+    using vector = typename labels::template vector<U>;
+    using labels::distances;
+    using labels::parents;
+    using labels::stamps;
+    using labels::current_stamp;
+
+    struct queue_entry {
+        double distance;
+        node_id node;
+
+        // std::push_heap builds a max heap, so "less" is reversed.
+        bool operator<(const queue_entry &other) const {
+            return distance > other.distance;
+        }
+    };
+
+    vector<queue_entry> queue;
+    size_t settled = 0;
+
+    void start_run(node_id n) {
+        this->start_labels(n);
+        queue.clear();
+        settled = 0;
+    }
+
+    template <class Graph, bool Instrumented>
+    void search(const Graph &g, node_id source, node_id target, double max_distance,
+                traversal_recorder<Instrumented> recorder) {
+        auto n = g.node_count();
+        if(source >= n || (target != no_node && target >= n)) {
+            throw std::logic_error("Unable to find the node");
+        }
+        auto started = recorder.now();
+        start_run(n);
+        stamps[source] = current_stamp;
+        distances[source] = 0;
+        parents[source] = no_node;
+        queue.push_back({0, source});
+        recorder.pushed();
+        recorder.add_setup_time(started);
+        started = recorder.now();
+        while(!queue.empty()) {
+            std::pop_heap(queue.begin(), queue.end());
+            auto entry = queue.back();
+            queue.pop_back();
+            recorder.popped();
+            if(entry.distance > distances[entry.node]) {
+                continue;
+            }
+            if(entry.distance > max_distance) {
+                break;
+            }
+            settled++;
+            recorder.settled();
+            if(entry.node == target) {
+                break;
+            }
+            g.for_each_out_edge(entry.node, [&](node_id next, double weight) {
+                recorder.relaxed();
+                auto distance = entry.distance + weight;
+                auto reached = stamps[next] == current_stamp;
+                if(!reached || distance < distances[next]) {
+                    if(reached) {
+                        recorder.decreased_key();
+                    }
+                    stamps[next] = current_stamp;
+                    distances[next] = distance;
+                    parents[next] = entry.node;
+                    queue.push_back({distance, next});
+                    std::push_heap(queue.begin(), queue.end());
+                    recorder.pushed();
+                }
+            });
+        }
+        recorder.add_search_time(started);
+    }
+
+public:
+    basic_dijkstra_workspace() = default;
+
+    explicit basic_dijkstra_workspace(const Allocator &allocator) :
+    labels(allocator), queue(allocator) {
+    }
+
+    // Runs Dijkstra from source.  If target is given, the run stops as soon
+    // as the target is settled;  if max_distance is given, it stops before
+    // settling anything further away than that.  Either way distance()
+    // and parent() are exact for every node settled before stopping;  nodes
+    // that were reached but not yet settled only have an upper bound.
+    template <class Graph>
+    void run(const Graph &g, node_id source, node_id target = no_node,
+             double max_distance = HUGE_VAL) {
+        search(g, source, target, max_distance, traversal_recorder<false>());
+    }
+
+    // The same, adding what the run did to stats.
+    template <class Graph>
+    void run(const Graph &g, node_id source, traversal_stats &stats, node_id target = no_node,
+             double max_distance = HUGE_VAL) {
+        search(g, source, target, max_distance, traversal_recorder<true>(stats));
+    }
+
+    // How many nodes the last run settled.
+    size_t settled_count() const {
+        return settled;
+    }
+};
+
+using dijkstra_workspace = basic_dijkstra_workspace<>;
+using pmr_dijkstra_workspace = basic_dijkstra_workspace<std::pmr::polymorphic_allocator<std::byte>>;
+
+#endif //DIJKSTRA_WORKSPACE_H
@@ -0,0 +1,87 @@
+#include "dynamic_sssp.hpp"
+
+#include <cassert>
+#include <iostream>
+#include <random>
+
+#include "graph_generators.hpp"
+
+// Keeps trees from several sources over a random graph, throws batches of
+// random weight changes at them (increases, decreases, and changes to the
+// edges the trees actually use), and after every batch checks each tree
+// against a fresh Dijkstra run:  the same distances, and parents that
+// really are on a shortest path.
+
+static void check(const shortest_path_tree<int> &tree, dijkstra_workspace &workspace) {
+    auto &g = tree.frozen();
+    workspace.run(g, tree.source());
+    size_t reachable = 0;
+    for(node_id u = 0; u < g.node_count(); ++u) {
+        assert(tree.distance(u) == workspace.distance(u));
+        reachable += tree.reached(u);
+        auto parent = tree.parent(u);
+        if(u == tree.source() || !tree.reached(u)) {
+            assert(parent == no_node);
+            continue;
+        }
+        auto found = false;
+        g.for_each_out_edge(parent, [&](node_id next, double w) {
+            found = found || (next == u && tree.distance(parent) + w == tree.distance(u));
+        });
+        assert(found);
+        assert(tree.in_subtree(parent, u));
+        assert(tree.depth(u) == tree.depth(parent) + 1);
+    }
+    assert(tree.subtree(tree.source()).size() == reachable);
+}
+
+void testDynamicSssp() {
+    std::cerr << "Initializing dynamic SSSP tests" << std::endl;
+    auto rng = std::default_random_engine {};
+    const int count = 1000;
+    auto pick = std::uniform_int_distribution<int>(0, count - 1);
+    // Whole number weights, so that there are ties to get right.
+    auto weight = std::uniform_int_distribution<int>(1, 20);
+    auto generated = erdos_renyi_graph(count, 4);
+    use_whole_weights(generated, 20);
+    auto g = std::make_shared<frozen_graph<int>>(freeze<int>(generated));
+    auto sssp = dynamic_sssp<int>(g);
+    for(auto source : {0, 1, 2, 3}) {
+        sssp.add_source(source);
+    }
+
+    auto workspace = dijkstra_workspace();
+    auto pick_edge = std::uniform_int_distribution<edge_id>(0, g->edge_count() - 1);
+    size_t recomputed = 0;
+    const int batches = 200;
+    for(auto batch = 0; batch < batches; ++batch) {
+        auto changes = std::vector<weight_change>();
+        for(auto k = 0; k < 5; ++k) {
+            changes.push_back({pick_edge(rng), double(weight(rng))});
+        }
+        // Always hit the tree from 0 somewhere, by changing the edge into a
+        // random reached node.
+        auto &tree = sssp.tree(0);
+        auto u = node_id(pick(rng));
+        if(tree.parent(u) != no_node) {
+            auto edge = g->find_edge(tree.parent(u), u);
+            changes.push_back({edge, g->weight(edge) * (batch % 2 == 0 ? 3 : 0.5)});
+        }
+        recomputed += sssp.update_weights(changes);
+        for(auto source : {0, 1, 2, 3}) {
+            check(sssp.tree(source), workspace);
+        }
+    }
+    // The point of repairing:  far less work than rerunning every source.
+    assert(recomputed < size_t(batches) * 4 * count / 4);
+
+    auto rejected = false;
+    try {
+        auto bad = std::vector<weight_change> {{0, 2.0}, {1, -1.0}};
+        sssp.update_weights(bad);
+    } catch(std::domain_error &) {
+        rejected = true;
+    }
+    assert(rejected);
+    check(sssp.tree(0), workspace);
+}
@@ -0,0 +1,86 @@
+#ifndef DYNAMIC_SSSP_H
+#define DYNAMIC_SSSP_H
+
+#include <memory>
+#include <span>
+#include <unordered_map>
+#include <vector>
+
+#include "frozen_graph.hpp"
+#include "shortest_path_tree.hpp"
+
+// Shortest path trees from a set of sources, kept up to date as edge
+// weights change.
+//
+// The expensive way to handle a weight change is to rerun Dijkstra from
+// every source.  But a change to a handful of edges usually only moves the
+// distances of a small part of each tree, so instead each tree is repaired
+// in place (see shortest_path_tree::repair), which only searches the part
+// that changed.
+//
+// The graph is shared with the trees:  update_weights changes it and then
+// repairs every tree, so between calls the trees always match the graph.
+// Not thread safe, and nothing else should change the graph's weights while
+// it is in use, or the trees won't match them any more.
+
+template <class T>
+class dynamic_sssp {
+private:
+    std::shared_ptr<frozen_graph<T>> working_graph;
+    std::unordered_map<T, shortest_path_tree<T>> trees;
+    dijkstra_workspace workspace;
+    std::vector<edge_id> changed;
+
+public:
+    explicit dynamic_sssp(std::shared_ptr<frozen_graph<T>> g) : working_graph(std::move(g)) {
+    }
+
+    const frozen_graph<T> &frozen() const {
+        return *working_graph;
+    }
+
+    // Computes the tree from source (if it isn't already kept) and keeps
+    // it up to date from now on.
+    const shortest_path_tree<T> &add_source(const T &source) {
+        auto itr = trees.find(source);
+        if(itr == trees.end()) {
+            auto id = working_graph->id(source);
+            itr = trees.emplace(source, build_shortest_path_tree<T>(working_graph, id, workspace)).first;
+        }
+        return itr->second;
+    }
+
+    void remove_source(const T &source) {
+        trees.erase(source);
+    }
+
+    const shortest_path_tree<T> &tree(const T &source) const {
+        auto itr = trees.find(source);
+        if(itr == trees.end()) {
+            throw std::logic_error("Unable to find the source");
+        }
+        return itr->second;
+    }
+
+    // Applies a batch of weight changes to the graph, then repairs every
+    // tree.  Returns the total number of nodes whose distances had to be
+    // recomputed, across all the trees (a fresh Dijkstra would be the
+    // number of reachable nodes, per tree).  If a change is invalid
+    // (unknown edge, weight not positive) nothing is changed.
+    size_t update_weights(std::span<const weight_change> changes) {
+        working_graph->update_weights(changes);
+        changed.clear();
+        for(auto &change : changes) {
+            changed.push_back(change.edge);
+        }
+        size_t recomputed = 0;
+        for(auto &itr : trees) {
+            recomputed += itr.second.repair(changed);
+        }
+        return recomputed;
+    }
+};
+
+void testDynamicSssp();
+
+#endif //DYNAMIC_SSSP_H
@@ -0,0 +1,82 @@
+#include "frozen_graph.hpp"
+
+#include <cassert>
+#include <iostream>
+#include <numeric>
+#include <thread>
+
+// Checks the weight updates:  that a batch lands in place and bumps the
+// version, that a bad batch changes nothing, and that readers running
+// alongside a writer never see a mix of two batches.
+
+void testFrozenGraph() {
+    std::cerr << "Initializing frozen graph tests" << std::endl;
+    const node_id count = 1000;
+    auto names = std::vector<int>();
+    auto edges = std::vector<frozen_edge>();
+    for(node_id i = 0; i < count; ++i) {
+        names.push_back(int(i));
+        edges.push_back({i, (i + 1) % count, 1.0});
+    }
+    auto g = frozen_graph<int>(std::move(names), edges);
+
+    auto edge = g.find_edge(5, 6);
+    assert(edge != no_edge && g.edge_start(edge) == 5 && g.edge_end(edge) == 6);
+    assert(g.find_edge(6, 5) == no_edge);
+    auto version = g.weights_version();
+    auto changes = std::vector<weight_change> {{edge, 2.5}, {g.find_edge(7, 8), 4.0}};
+    g.update_weights(changes);
+    assert(g.weight(edge) == 2.5 && g.weight(g.find_edge(7, 8)) == 4.0);
+    assert(g.weights_version() > version);
+    g.for_each_in_edge(6, [&](node_id previous, double w) { assert(previous == 5 && w == 2.5); });
+
+    auto rejected = false;
+    try {
+        auto bad = std::vector<weight_change> {{edge, 3.0}, {g.edge_count(), 1.0}};
+        g.update_weights(bad);
+    } catch(std::logic_error &) {
+        rejected = true;
+    }
+    assert(rejected && g.weight(edge) == 2.5);
+
+    // The writer flips between two layouts that have the same total weight
+    // (every edge 1, or alternately 0.5 and 1.5), a batch at a time, so a
+    // reader that ever sees a mix of them gets the wrong total.
+    auto even = std::vector<weight_change>();
+    auto uneven = std::vector<weight_change>();
+    for(edge_id k = 0; k < g.edge_count(); ++k) {
+        even.push_back({k, 1.0});
+        uneven.push_back({k, k % 2 == 0 ? 0.5 : 1.5});
+    }
+    g.update_weights(even);
+    auto done = std::atomic<bool>(false);
+    auto writer = std::thread([&] {
+        for(auto i = 0; i < 2000; ++i) {
+            g.update_weights(i % 2 == 0 ? uneven : even);
+        }
+        done = true;
+    });
+    size_t reads = 0;
+    while(!done || reads < 100) {
+        auto total = g.read_weights([&] {
+            double sum = 0;
+            for(node_id u = 0; u < g.node_count(); ++u) {
+                g.for_each_out_edge(u, [&](node_id, double w) { sum += w; });
+            }
+            return sum;
+        });
+        assert(total == double(count));
+        // And a reader that only fills in its own snapshot.
+        auto snapshot = std::vector<double>();
+        g.read_weights([&] {
+            snapshot.clear();
+            for(node_id u = 0; u < g.node_count(); ++u) {
+                g.for_each_out_edge(u, [&](node_id, double w) { snapshot.push_back(w); });
+            }
+        });
+        assert(snapshot.size() == g.edge_count());
+        assert(std::accumulate(snapshot.begin(), snapshot.end(), 0.0) == double(count));
+        reads++;
+    }
+    writer.join();
+}
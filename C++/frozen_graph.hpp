@@ -0,0 +1,384 @@
+#ifndef FROZEN_GRAPH_H
+#define FROZEN_GRAPH_H
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <limits>
+#include <span>
+#include <stdexcept>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+#include "graph.hpp"
+
+// The graph<T> class is built for being easy to modify:  every node and
+// every edge is its own heap object, and everything is tied together with
+// shared_ptrs and hash tables.  That is great for create_node/create_link,
+// but it is terrible for the heavy-lifting algorithms, which spend most of
+// their time chasing pointers and hashing.
+//
+// So for those algorithms we "freeze" the graph into a compact form.  Every
+// node gets a dense integer id (0..n-1), and the edges are laid out in
+// Compressed Sparse Row (CSR) form:  all the out edges of node 0, then all
+// the out edges of node 1, and so on, with an offsets array saying where each
+// node's edges start.  The out edges of node u are then simply
+// targets[offsets[u] .. offsets[u+1]).
+//
+// We also build the reverse (in edge) CSR, since several algorithms need to
+// walk edges backwards.  Rather than duplicating the weights, each in edge
+// records the index of the forward edge it corresponds to, so the weights
+// array stays the single source of truth.
+//
+// A frozen_graph is a snapshot:  later changes to the graph<T> it was built
+// from are not reflected in it.  Its structure never changes, but its
+// weights can, in place (see update_weights).
+
+using node_id = std::uint32_t;
+using edge_id = std::size_t;
+
+// Used as "no node", e.g. for the parent of the start of a traversal.
+constexpr node_id no_node = std::numeric_limits<node_id>::max();
+
+// Used as "no edge", e.g. by find_edge when there isn't one.
+constexpr edge_id no_edge = std::numeric_limits<edge_id>::max();
+
+// A single edge in dense ids, used when building a frozen_graph in bulk.
+struct frozen_edge {
+    node_id start;
+    node_id end;
+    double weight;
+};
+
+// A new weight for an existing edge, for update_weights.
+struct weight_change {
+    edge_id edge;
+    double weight;
+};
+
+// The version counter for a frozen_graph's weights (see update_weights).
+// It is only wrapped up like this so that frozen_graphs can still be copied
+// and moved, which a bare std::atomic member would prevent.  Copying a
+// graph while its weights are being updated isn't supported.
+class weight_version {
+private:
+    std::atomic<std::uint64_t> value {0};
+
+public:
+    weight_version() = default;
+
+    weight_version(const weight_version &other) : value(other.value.load(std::memory_order_acquire)) {
+    }
+
+    weight_version &operator=(const weight_version &other) {
+        value.store(other.value.load(std::memory_order_acquire), std::memory_order_release);
+        return *this;
+    }
+
+    std::atomic<std::uint64_t> &counter() {
+        return value;
+    }
+
+    const std::atomic<std::uint64_t> &counter() const {
+        return value;
+    }
+};
+
+template <class T>
+class frozen_graph {
+private:
+    std::vector<T> names;
+    std::unordered_map<T, node_id> ids;
+
+    std::vector<edge_id> out_offsets;
+    std::vector<node_id> out_targets;
+    std::vector<double> out_weights;
+
+    std::vector<edge_id> in_offsets;
+    std::vector<node_id> in_sources;
+    std::vector<edge_id> in_edges;
+
+    weight_version version;
+
+    // Weights can be written while other threads read them, so every access
+    // goes through an atomic_ref:  no torn doubles, and no data race in the
+    // C++ sense.  Relaxed loads and stores compile to plain moves on the
+    // usual hardware, so readers pay nothing for this.
+    double load_weight(edge_id edge) const {
+        return std::atomic_ref<double>(const_cast<double &>(out_weights[edge])).load(std::memory_order_relaxed);
+    }
+
+    void store_weight(edge_id edge, double weight) {
+        std::atomic_ref<double>(out_weights[edge]).store(weight, std::memory_order_relaxed);
+    }
+
+    void index_names() {
+        if(names.size() >= no_node) {
+            throw std::domain_error("Too many nodes for a frozen graph");
+        }
+        ids.reserve(names.size());
+        for(node_id i = 0; i < names.size(); ++i) {
+            if(ids.contains(names[i])) {
+                throw std::domain_error("Node already exists");
+            }
+            ids[names[i]] = i;
+        }
+    }
+
+    // Lays the edges out in CSR form with a counting sort: first count
+    // the degree of every node, turn the counts into starting offsets with
+    // a prefix sum, and then drop every edge into its slot.  This is linear
+    // in the size of the graph, unlike sorting the edges.
+    void build(const std::vector<frozen_edge> &edges) {
+        auto n = names.size();
+        out_offsets.assign(n + 1, 0);
+        in_offsets.assign(n + 1, 0);
+        for(auto &e : edges) {
+            if(e.start >= n || e.end >= n) {
+                throw std::domain_error("Node does not exist");
+            }
+            if(!(e.weight > 0)) {
+                throw std::domain_error("Weights must be positive");
+            }
+            out_offsets[e.start + 1]++;
+            in_offsets[e.end + 1]++;
+        }
+        for(size_t i = 0; i < n; ++i) {
+            out_offsets[i + 1] += out_offsets[i];
+            in_offsets[i + 1] += in_offsets[i];
+        }
+        out_targets.resize(edges.size());
+        out_weights.resize(edges.size());
+        in_sources.resize(edges.size());
+        in_edges.resize(edges.size());
+
+        auto out_fill = std::vector<edge_id>(out_offsets.begin(), out_offsets.end() - 1);
+        for(auto &e : edges) {
+            auto slot = out_fill[e.start]++;
+            out_targets[slot] = e.end;
+            out_weights[slot] = e.weight;
+        }
+        // Building the reverse side from the finished forward side (rather
+        // than from the input) means in_edges can point at forward slots.
+        auto in_fill = std::vector<edge_id>(in_offsets.begin(), in_offsets.end() - 1);
+        for(node_id u = 0; u < n; ++u) {
+            for(auto k = out_offsets[u]; k < out_offsets[u + 1]; ++k) {
+                auto slot = in_fill[out_targets[k]]++;
+                in_sources[slot] = u;
+                in_edges[slot] = k;
+            }
+        }
+    }
+
+public:
+    // Freezes an existing graph.  The node ids follow the iteration order
+    // of the graph's node table.
+    explicit frozen_graph(const graph<T> &g) {
+        names.reserve(g.nodes.size());
+        for(auto &itr : g.nodes) {
+            names.push_back(itr.first);
+        }
+        index_names();
+        auto edges = std::vector<frozen_edge>();
+        for(auto &itr : g.nodes) {
+            for(auto &edge : itr.second->out_edges) {
+                edges.push_back({ids[edge->start->name], ids[edge->end->name], edge->weight});
+            }
+        }
+        build(edges);
+    }
+
+    // Builds directly from a list of names (node i is names[i]) and a list of
+    // edges between those ids, skipping graph<T> entirely.  Unlike
+    // create_link, this does not reject parallel edges:  the algorithms all
+    // handle them, and checking for them would cost a hash per edge.
+    frozen_graph(std::vector<T> namesIn, const std::vector<frozen_edge> &edges) :
+    names(std::move(namesIn)) {
+        index_names();
+        build(edges);
+    }
+
+    node_id node_count() const {
+        return static_cast<node_id>(names.size());
+    }
+
+    size_t edge_count() const {
+        return out_targets.size();
+    }
+
+    const T &name(node_id node) const {
+        return names[node];
+    }
+
+    bool contains(const T &name) const {
+        return ids.contains(name);
+    }
+
+    node_id id(const T &name) const {
+        auto itr = ids.find(name);
+        if(itr == ids.end()) {
+            throw std::logic_error("Unable to find the node");
+        }
+        return itr->second;
+    }
+
+    size_t out_degree(node_id node) const {
+        return out_offsets[node + 1] - out_offsets[node];
+    }
+
+    size_t in_degree(node_id node) const {
+        return in_offsets[node + 1] - in_offsets[node];
+    }
+
+    std::span<const node_id> out_neighbors(node_id node) const {
+        return {out_targets.data() + out_offsets[node], out_degree(node)};
+    }
+
+    std::span<const node_id> in_neighbors(node_id node) const {
+        return {in_sources.data() + in_offsets[node], in_degree(node)};
+    }
+
+    // Edges have ids too:  the out edges of node u are the ids
+    // first_out_edge(u) up to (but not including) first_out_edge(u + 1).
+    edge_id first_out_edge(node_id node) const {
+        return out_offsets[node];
+    }
+
+    // The first edge from start to end, or no_edge if there isn't one.
+    edge_id find_edge(node_id start, node_id end) const {
+        for(auto k = out_offsets[start]; k < out_offsets[start + 1]; ++k) {
+            if(out_targets[k] == end) {
+                return k;
+            }
+        }
+        return no_edge;
+    }
+
+    // The start of an edge takes a binary search over the offsets, since
+    // the CSR layout only records where each node's edges begin.
+    node_id edge_start(edge_id edge) const {
+        auto itr = std::upper_bound(out_offsets.begin(), out_offsets.end(), edge);
+        return static_cast<node_id>(itr - out_offsets.begin() - 1);
+    }
+
+    node_id edge_end(edge_id edge) const {
+        return out_targets[edge];
+    }
+
+    double weight(edge_id edge) const {
+        return load_weight(edge);
+    }
+
+    // The structure of a frozen graph is fixed, but its weights can change
+    // (travel times change, links get congested), in place and while other
+    // threads are reading the graph.  Anything computed from the old
+    // weights, such as a shortest_path_tree, is stale until it is
+    // recomputed or repaired.
+    //
+    // Every single weight a reader loads is either the old or the new value.
+    // For readers that need the whole batch at once (a traversal mixing old
+    // and new weights could find a path that never existed at any one
+    // time), the weights have a version number, used as a seqlock:  it is
+    // odd while an update is being written and even otherwise, so
+    // read_weights can tell whether an update overlapped it and, if so, try
+    // again.  Writers never wait for readers, and readers never block
+    // writers;  they only retry.  Concurrent update_weights calls take
+    // turns.
+    //
+    // The whole batch is checked before anything is written, so an invalid
+    // change (unknown edge, weight not positive) throws with nothing
+    // changed.
+    void update_weights(std::span<const weight_change> changes) {
+        for(auto &change : changes) {
+            if(change.edge >= out_weights.size()) {
+                throw std::logic_error("Unable to find the edge");
+            }
+            if(!(change.weight > 0)) {
+                throw std::domain_error("Weights must be positive");
+            }
+        }
+        auto &counter = version.counter();
+        auto current = counter.load(std::memory_order_relaxed);
+        while((current & 1) != 0 ||
+              !counter.compare_exchange_weak(current, current + 1, std::memory_order_acquire)) {
+            if((current & 1) != 0) {
+                std::this_thread::yield();
+            }
+            current = counter.load(std::memory_order_relaxed);
+        }
+        // The release fence keeps the stores below from being seen before the
+        // counter went odd.
+        std::atomic_thread_fence(std::memory_order_release);
+        for(auto &change : changes) {
+            store_weight(change.edge, change.weight);
+        }
+        counter.store(current + 2, std::memory_order_release);
+    }
+
+    void set_weight(edge_id edge, double weight) {
+        auto change = weight_change {edge, weight};
+        update_weights({&change, 1});
+    }
+
+    // Even, and different after every update.
+    std::uint64_t weights_version() const {
+        return version.counter().load(std::memory_order_acquire) & ~std::uint64_t(1);
+    }
+
+    // Runs f() (and returns what it returns, if anything) so that every weight it reads
+    // comes from the same version:  if an update overlapped the run, f is
+    // simply run again, so f must be safe to repeat.  Long reads against a
+    // constant stream of updates may need several tries.
+    template <class F>
+    auto read_weights(F &&f) const {
+        auto &counter = version.counter();
+        while(true) {
+            auto before = counter.load(std::memory_order_acquire);
+            if((before & 1) != 0) {
+                // A writer is part way through.  Give up the time slice rather
+                // than spin:  on a busy (or single core) machine the writer
+                // may be waiting for this very core to finish its update.
+                std::this_thread::yield();
+                continue;
+            }
+            // A void f fills in the caller's own state instead, which is
+            // just as consistent once the version check passes.
+            if constexpr (std::is_void_v<std::invoke_result_t<F &>>) {
+                f();
+                std::atomic_thread_fence(std::memory_order_acquire);
+                if(counter.load(std::memory_order_relaxed) == before) {
+                    return;
+                }
+            } else {
+                auto result = f();
+                std::atomic_thread_fence(std::memory_order_acquire);
+                if(counter.load(std::memory_order_relaxed) == before) {
+                    return result;
+                }
+            }
+        }
+    }
+
+    // The algorithms walk the edges through these two callbacks rather than
+    // touching the arrays directly, so that they can run over any other
+    // adjacency representation that offers the same two functions.
+    // f is called as f(neighbor, weight).
+    template <class F>
+    void for_each_out_edge(node_id node, F &&f) const {
+        for(auto k = out_offsets[node]; k < out_offsets[node + 1]; ++k) {
+            f(out_targets[k], load_weight(k));
+        }
+    }
+
+    template <class F>
+    void for_each_in_edge(node_id node, F &&f) const {
+        for(auto k = in_offsets[node]; k < in_offsets[node + 1]; ++k) {
+            f(in_sources[k], load_weight(in_edges[k]));
+        }
+    }
+};
+
+void testFrozenGraph();
+
+#endif //FROZEN_GRAPH_H
@@ -0,0 +1,317 @@
+#ifndef GENERATOR_H
+#define GENERATOR_H
+
+#include <coroutine>
+#include <cstddef>
+#include <exception>
+#include <iterator>
+#include <memory>
+#include <new>
+#include <span>
+#include <utility>
+
+// A minimal generator for C++20 coroutines, standing in for C++23's
+// std::generator (which our compilers don't all have yet).
+//
+// A coroutine is a function that can suspend itself part way through and
+// be resumed later, with all its local variables intact.  That makes it a
+// far more natural way to write a lazy traversal than an iterator:  the
+// traversal is written as an ordinary loop, and every time it has a result
+// it does "co_yield result;", which hands the result to whoever is
+// iterating and suspends until they ask for the next one.  Compare that
+// with dijkstra_traversal_iterator, where the loop has to be taken apart
+// by hand into "set up" and "do one step" pieces, with all the loop's
+// state turned into member variables.
+//
+// A generator<Y> is an input range:  begin() runs the coroutine up to its
+// first co_yield, * gives the value yielded, ++ resumes the coroutine up
+// to the next co_yield, and the iterator equals end() once the coroutine
+// finishes.  Just like the iterator version, nothing is computed until
+// it's asked for.
+//
+// The one cost a coroutine adds is its "frame", the block of memory where
+// its locals live while it is suspended, which the compiler normally gets
+// from the heap.  Two things avoid that here:
+//
+// - By default frames come from a small per-thread cache of recently freed
+//   frames, so once a thread has run one traversal, the next one reuses
+//   the same memory rather than calling the allocator.
+//
+// - A caller that wants a guarantee can give a frame_arena (a buffer they
+//   own, say on the stack) to with_frame_arena, and the frame is carved out
+//   of that.  A frame that doesn't fit in the arena falls back to the
+//   cache.
+
+class frame_arena {
+private:
+    std::byte *base;
+    size_t capacity;
+    size_t top = 0;
+
+public:
+    static constexpr size_t alignment = alignof(std::max_align_t);
+
+    static constexpr size_t round_up(size_t n) {
+        return (n + alignment - 1) / alignment * alignment;
+    }
+
+    explicit frame_arena(std::span<std::byte> buffer) {
+        void *start = buffer.data();
+        size_t space = buffer.size();
+        if(std::align(alignment, 0, start, space) == nullptr) {
+            space = 0;
+        }
+        base = static_cast<std::byte *>(start);
+        capacity = space / alignment * alignment;
+    }
+
+    frame_arena(const frame_arena &) = delete;
+    frame_arena &operator=(const frame_arena &) = delete;
+
+    // Returns nullptr if there is no room.
+    void *allocate(size_t n) {
+        n = round_up(n);
+        if(n > capacity - top) {
+            return nullptr;
+        }
+        auto result = base + top;
+        top += n;
+        return result;
+    }
+
+    // The arena is a stack:  freeing the most recent allocation gives its
+    // space back, and anything else is only reclaimed once everything
+    // above it has been freed too.
+    void deallocate(void *p, size_t n) {
+        n = round_up(n);
+        if(static_cast<std::byte *>(p) + n == base + top) {
+            top -= n;
+        }
+    }
+
+    size_t used() const {
+        return top;
+    }
+
+    // The arena that the next coroutine frame allocated on this thread
+    // should come from, if any.  Set by with_frame_arena.
+    static frame_arena *&next() {
+        thread_local frame_arena *arena = nullptr;
+        return arena;
+    }
+};
+
+// Calls make(), which should call a generator coroutine and return the
+// generator, with that coroutine's frame placed in arena.  A coroutine's
+// frame is allocated right when it is called, before it runs any of its
+// body, so this just has to point the allocator at the arena for the
+// length of that call.
+template <class F>
+auto with_frame_arena(frame_arena &arena, F &&make) {
+    frame_arena::next() = &arena;
+    try {
+        auto result = make();
+        frame_arena::next() = nullptr;
+        return result;
+    } catch(...) {
+        frame_arena::next() = nullptr;
+        throw;
+    }
+}
+
+// The per-thread cache of freed frames.
+class frame_cache {
+private:
+    static constexpr size_t slots = 4;
+    void *blocks[slots] {};
+    size_t sizes[slots] {};
+
+public:
+    ~frame_cache() {
+        for(auto block : blocks) {
+            ::operator delete(block);
+        }
+    }
+
+    void *allocate(size_t n) {
+        for(size_t i = 0; i < slots; ++i) {
+            if(blocks[i] != nullptr && sizes[i] >= n) {
+                auto result = blocks[i];
+                blocks[i] = nullptr;
+                return result;
+            }
+        }
+        return ::operator new(n);
+    }
+
+    void deallocate(void *p, size_t n) {
+        for(size_t i = 0; i < slots; ++i) {
+            if(blocks[i] == nullptr) {
+                blocks[i] = p;
+                sizes[i] = n;
+                return;
+            }
+        }
+        ::operator delete(p);
+    }
+
+    static frame_cache &local() {
+        thread_local frame_cache cache;
+        return cache;
+    }
+};
+
+template <class Y>
+class generator {
+public:
+    struct promise_type {
+        const Y *current = nullptr;
+        std::exception_ptr error = nullptr;
+
+        generator get_return_object() {
+            return generator(std::coroutine_handle<promise_type>::from_promise(*this));
+        }
+
+        // Lazy:  nothing runs until begin() is called.
+        std::suspend_always initial_suspend() noexcept {
+            return {};
+        }
+
+        std::suspend_always final_suspend() noexcept {
+            return {};
+        }
+
+        // The yielded value lives in the coroutine until it is resumed, so
+        // we only need to keep a pointer to it.
+        std::suspend_always yield_value(const Y &value) noexcept {
+            current = std::addressof(value);
+            return {};
+        }
+
+        void return_void() {
+        }
+
+        void unhandled_exception() {
+            error = std::current_exception();
+        }
+
+        // Every frame starts with a small header recording where it came
+        // from (an arena, or the per-thread cache), since operator delete
+        // only gets the pointer and the size.
+        struct frame_header {
+            frame_arena *arena;
+            size_t size;
+        };
+        static constexpr size_t header_size = frame_arena::round_up(sizeof(frame_header));
+
+        static void *allocate_frame(size_t size, frame_arena *arena) {
+            size += header_size;
+            void *block = nullptr;
+            if(arena != nullptr) {
+                block = arena->allocate(size);
+            }
+            if(block == nullptr) {
+                arena = nullptr;
+                block = frame_cache::local().allocate(size);
+            }
+            ::new(block) frame_header {arena, size};
+            return static_cast<std::byte *>(block) + header_size;
+        }
+
+        // The arena (if any) for a frame comes from with_frame_arena, rather
+        // than the usual convention of passing std::allocator_arg and an
+        // allocator as the coroutine's first arguments.  That way any
+        // coroutine can use an arena without changing its signature.
+        static void *operator new(size_t size) {
+            return allocate_frame(size, std::exchange(frame_arena::next(), nullptr));
+        }
+
+        static void operator delete(void *frame, size_t) {
+            auto block = static_cast<std::byte *>(frame) - header_size;
+            auto header = *reinterpret_cast<frame_header *>(block);
+            if(header.arena != nullptr) {
+                header.arena->deallocate(block, header.size);
+            } else {
+                frame_cache::local().deallocate(block, header.size);
+            }
+        }
+    };
+
+    struct iterator {
+        using value_type = Y;
+        using difference_type = std::ptrdiff_t;
+
+        std::coroutine_handle<promise_type> handle = nullptr;
+
+        const Y &operator*() const {
+            return *handle.promise().current;
+        }
+
+        const Y *operator->() const {
+            return handle.promise().current;
+        }
+
+        iterator &operator++() {
+            handle.resume();
+            rethrow();
+            return *this;
+        }
+
+        void operator++(int) {
+            ++*this;
+        }
+
+        bool operator==(std::default_sentinel_t) const {
+            return handle == nullptr || handle.done();
+        }
+
+        void rethrow() const {
+            if(handle.promise().error != nullptr) {
+                std::rethrow_exception(std::exchange(handle.promise().error, nullptr));
+            }
+        }
+    };
+
+private:
+    std::coroutine_handle<promise_type> handle = nullptr;
+
+    explicit generator(std::coroutine_handle<promise_type> h) : handle(h) {
+    }
+
+public:
+    generator(generator &&other) noexcept : handle(std::exchange(other.handle, nullptr)) {
+    }
+
+    generator &operator=(generator &&other) noexcept {
+        if(this != &other) {
+            if(handle) {
+                handle.destroy();
+            }
+            handle = std::exchange(other.handle, nullptr);
+        }
+        return *this;
+    }
+
+    ~generator() {
+        if(handle) {
+            handle.destroy();
+        }
+    }
+
+    // Runs the coroutine up to its first co_yield.  Like any input range,
+    // a generator can only be iterated once.
+    iterator begin() {
+        auto itr = iterator {handle};
+        if(handle && !handle.done()) {
+            handle.resume();
+            itr.rethrow();
+        }
+        return itr;
+    }
+
+    std::default_sentinel_t end() const {
+        return std::default_sentinel;
+    }
+};
+
+#endif //GENERATOR_H
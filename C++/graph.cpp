@@ -3,16 +3,23 @@
 //
 
 #include "graph.hpp"
+#include "counting_allocator.hpp"
 
  
 #include <cassert>
 #include <random>
+#include <ranges>
 
 // Basically this file is a noop:  Because all our stuff
 // is using templates for parameterized typing the result is that
 // effectively everythirg is in the header.  However, we have
 // our testing code here in the testGraph function
 
+static_assert(std::input_iterator<dijkstra_traversal_iterator<int>>);
+static_assert(std::sentinel_for<dijkstra_traversal_sentinel, dijkstra_traversal_iterator<int>>);
+static_assert(std::ranges::input_range<dijkstra_traversal<int>>);
+static_assert(std::ranges::view<dijkstra_traversal<int>>);
+
 void testGraph() {
     std::cerr << "Initializing graph tests" << std::endl;
     auto array = std::vector<int>(10);
@@ -58,5 +65,163 @@ void testGraph() {
             assert(step->distance == float(i));
             i++;
         }
+
+        // And the same traversal through the std::views adaptors:  stop
+        // once the distance reaches 6, and only keep the even nodes.
+        auto near = dijkstra_traversal<int>(g, 0)
+                    | std::views::take_while([](auto &step) { return step->distance < 6; })
+                    | std::views::filter([](auto &step) { return step->current->name % 2 == 0; });
+        i = 0;
+        for(auto &step : near) {
+            assert(step->current->name == i);
+            i += 2;
+        }
+        assert(i == 6);
+
+        // Removing the 5->6 link leaves 6 only reachable over a direct link
+        // of weight 11, and removing node 3 takes every link to or from it
+        // away too (so 4 is only reachable directly as well).
+        g->remove_link(5, 6);
+        auto distances = std::unordered_map<int, double>();
+        for(auto step : dijkstra_traversal<int>(g, 0)) {
+            distances[step->current->name] = step->distance;
+        }
+        assert(distances[5] == 5 && distances[6] == 11);
+        g->remove_node(3);
+        distances.clear();
+        for(auto step : dijkstra_traversal<int>(g, 0)) {
+            distances[step->current->name] = step->distance;
+        }
+        assert(distances.size() == 9 && !distances.contains(3));
+        assert(distances[2] == 2 && distances[4] == 11 && distances[5] == 11);
+
+        auto removed = [&](auto &&remove) {
+            try {
+                remove();
+            } catch(std::domain_error &) {
+                return true;
+            }
+            return false;
+        };
+        assert(removed([&] { g->remove_link(5, 6); }));
+        assert(removed([&] { g->remove_link(2, 3); }));
+        assert(removed([&] { g->remove_node(3); }));
+        // A removed link can be made again, and a removed node too.
+        g->create_link(5, 6, 1.0);
+        g->create_node(3);
+        g->create_link(2, 3, 1.0);
+        distances.clear();
+        for(auto step : dijkstra_traversal<int>(g, 0)) {
+            distances[step->current->name] = step->distance;
+        }
+        assert(distances[3] == 3 && distances[4] == 11);
+    }
+
+    // Self loops sit in the same node's out and in lists, which is the
+    // awkward case for removal.
+    auto loops = std::make_shared<graph<int>>();
+    for(i = 0; i < 4; ++i) {
+        loops->create_node(i);
+    }
+    for(i = 0; i < 4; ++i) {
+        for(auto j = 0; j < 4; ++j) {
+            loops->create_link(i, j, 1.0 + j);
+        }
+    }
+    loops->remove_link(1, 1);
+    loops->remove_node(2);
+    loops->remove_link(0, 3);
+    auto count = 0;
+    for(auto step : dijkstra_traversal<int>(loops, 0)) {
+        count++;
+        if(step->current->name == 3) {
+            assert(step->distance == 6);
+        }
+    }
+    assert(count == 3);
+
+    // A step can outlive the graph it came from:  its nodes (and the arena
+    // they live in) stay valid, just with no edges any more.
+    auto kept = std::shared_ptr<dijkstra_iteration_step<int>>();
+    for(auto step : dijkstra_traversal<int>(loops, 0)) {
+        kept = step;
+    }
+    loops.reset();
+    assert(kept->current->name == 3 && kept->previous->name == 1);
+
+    // Space freed by removals gets reused.
+    auto arena = graph_arena();
+    auto first = arena.allocate(40);
+    arena.deallocate(first, 40);
+    assert(arena.allocate(40) == first);
+    arena.release_all();
+    auto second = arena.allocate(40);
+    arena.deallocate(second, 40);
+    assert(arena.allocate(40) != second);
+
+    // memory_usage:  every category grows with what it should.
+    auto named = std::make_shared<graph<std::string>>();
+    auto empty_usage = named->memory_usage();
+    assert(empty_usage.node_bytes == 0 && empty_usage.edge_bytes == 0 && empty_usage.adjacency_bytes == 0 &&
+           empty_usage.name_bytes == 0);
+    for(i = 0; i < 100; ++i) {
+        named->create_node(std::to_string(i));
+    }
+    auto nodes_usage = named->memory_usage();
+    assert(nodes_usage.node_bytes >= 100 * sizeof(graph_node<std::string>));
+    assert(nodes_usage.edge_bytes == 0 && nodes_usage.adjacency_bytes == 0);
+    assert(nodes_usage.name_bytes == 0);
+    assert(nodes_usage.hash_table_bytes > empty_usage.hash_table_bytes);
+    for(i = 0; i < 100; ++i) {
+        named->create_link(std::to_string(i), std::to_string((i + 1) % 100), 1.0);
+    }
+    auto edges_usage = named->memory_usage();
+    assert(edges_usage.node_bytes == nodes_usage.node_bytes);
+    assert(edges_usage.edge_bytes >= 100 * sizeof(graph_edge<std::string>));
+    assert(edges_usage.adjacency_bytes >= 100 * 2 * sizeof(std::shared_ptr<void>));
+    assert(edges_usage.arena_bytes >= edges_usage.node_bytes + edges_usage.edge_bytes);
+    assert(edges_usage.total() > nodes_usage.total());
+    assert(edges_usage.reserved_total() >= edges_usage.total());
+    // Names too long to keep inline live on the heap, twice over.
+    auto long_name = std::string(100, 'x');
+    named->create_node(long_name);
+    assert(named->memory_usage().name_bytes >= 2 * 101);
+    named->remove_node(long_name);
+    assert(named->memory_usage().name_bytes == 0);
+
+    // A graph given a memory resource takes all its memory from it, and
+    // gives it all back once the graph (and every node) is gone.  And a
+    // traversal can keep its scratch space in a monotonic buffer.
+    auto counts = allocation_counts();
+    auto resource = counting_resource(counts);
+    {
+        auto placed = std::make_shared<graph<int>>(&resource);
+        assert(placed->memory_resource() == &resource);
+        for(i = 0; i < 50; ++i) {
+            placed->create_node(i);
+        }
+        for(i = 0; i < 50; ++i) {
+            placed->create_link(i, (i + 1) % 50, 1.0);
+        }
+        assert(counts.allocations > 0);
+        auto graph_bytes = counts.bytes_in_use;
+        auto scratch_counts = allocation_counts();
+        auto scratch_upstream = counting_resource(scratch_counts);
+        {
+            auto scratch = std::pmr::monotonic_buffer_resource(&scratch_upstream);
+            i = 0;
+            for(auto &step : dijkstra_traversal<int>(placed, 0, &scratch)) {
+                assert(step->distance == i);
+                i++;
+            }
+            assert(i == 50);
+            assert(scratch_counts.allocations > 0);
+            assert(counts.bytes_in_use == graph_bytes);
+        }
+        assert(scratch_counts.bytes_in_use == 0);
+        placed->remove_node(10);
+        auto copy = graph<int>(*placed);
+        assert(copy.memory_resource() == std::pmr::get_default_resource());
     }
-}
\ No newline at end of file
+    assert(counts.bytes_in_use == 0);
+}
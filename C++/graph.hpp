@@ -6,11 +6,18 @@
 #define GRAPH_H
 #include <iostream>
 #include <map>
-#include <unordered_set>
 #include <unordered_map>
+#include <vector>
 #include <memory>
+#include <memory_resource>
 #include <cmath>
 #include <algorithm>
+#include <iterator>
+#include <ranges>
+#include <string>
+
+#include "graph_arena.hpp"
+#include "traversal_stats.hpp"
 
 // C++ is somewhat obnoxious here:  You can't do a circular
 // reference, so we declare all the classes we will use all up here
@@ -30,37 +37,189 @@ template <class T> class graph_node;
 template <class T> class graph_edge;
 template <class T> class graph;
 template <class T> struct dijkstra_iteration_step;
-template <class T> class dijkstra_traversal;
-template <class T> struct dijkstra_traversal_iterator;
+template <class T, bool Instrumented = false> class dijkstra_traversal;
+template <class T, bool Instrumented = false> struct dijkstra_traversal_iterator;
+template <class T> class frozen_graph;
+template <class T> struct dijkstra_coroutine;
+template <class T, bool Instrumented = false> class bfs_traversal_iterator;
+template <class T, bool Instrumented = false> class dfs_traversal_iterator;
+
+// Where a graph<T>'s memory goes, from graph::memory_usage().
+struct graph_memory_usage {
+    // The node objects, with their shared_ptr control blocks.
+    size_t node_bytes = 0;
+    // The edge objects likewise.
+    size_t edge_bytes = 0;
+    // The adjacency lists pointing at the edges, in and out.
+    size_t adjacency_bytes = 0;
+    // The name -> node table:  its buckets and an entry per node.
+    size_t hash_table_bytes = 0;
+    // Memory the names themselves own on the heap (the characters of long
+    // strings, say), for both copies:  the table's key and the node's name.
+    size_t name_bytes = 0;
+    // What the arena the nodes and edges live in has reserved, used or not.
+    // node_bytes and edge_bytes are the part of this in use.
+    size_t arena_bytes = 0;
+
+    // The memory in use.  The arena is left out, since the nodes and edges
+    // are already counted inside it.
+    size_t total() const {
+        return node_bytes + edge_bytes + adjacency_bytes + hash_table_bytes + name_bytes;
+    }
+
+    // The memory actually taken, for capacity planning:  the same, but with
+    // the whole arena in place of the nodes and edges carved out of it.
+    size_t reserved_total() const {
+        return arena_bytes + adjacency_bytes + hash_table_bytes + name_bytes;
+    }
+};
+
+// Heap memory a node name owns, beyond the name object itself.  Only
+// strings own any (and short ones keep their characters inline);  other
+// name types that do can overload this.
+template <class T>
+size_t name_heap_bytes(const T &) {
+    return 0;
+}
+
+template <class C, class Traits, class A>
+size_t name_heap_bytes(const std::basic_string<C, Traits, A> &name) {
+    auto inline_start = reinterpret_cast<const std::byte *>(&name);
+    auto data = reinterpret_cast<const std::byte *>(name.data());
+    if(data >= inline_start && data < inline_start + sizeof(name)) {
+        return 0;
+    }
+    return (name.capacity() + 1) * sizeof(C);
+}
 
 // The primary class for a Graph.
 //
 // This implementation uses an adjacency list within each node, and the graph
 // itself has a name->node mapping.
+//
+// All of a graph's memory (the name->node table, the nodes' edge lists,
+// and the arena the nodes and edges are carved out of) comes from one
+// std::pmr::memory_resource, the default resource unless one is given to
+// the constructor.  That's what lets a whole graph be placed somewhere
+// particular:  in huge pages or NUMA local memory, say, given a resource
+// that hands those out (ideally behind a std::pmr pool or monotonic buffer,
+// as the arena asks for 64 KiB at a time).  The resource has to outlive
+// the graph and every node and edge anyone holds on to.
 template <class T>
 class graph {
 private:
-    std::unordered_map<T, std::shared_ptr<graph_node<T>>> nodes {};  
+    std::pmr::unordered_map<T, std::shared_ptr<graph_node<T>>> nodes {};
+    // Where the nodes and edges themselves are allocated (see graph_arena.hpp).
+    std::shared_ptr<graph_arena> arena = std::make_shared<graph_arena>();
     friend graph_edge<T>;
     friend graph_node<T>;
-    friend dijkstra_traversal_iterator<T>;
+    template <class, bool> friend struct dijkstra_traversal_iterator;
+    friend dijkstra_coroutine<T>;
+    template <class, bool> friend class bfs_traversal_iterator;
+    template <class, bool> friend class dfs_traversal_iterator;
+    friend frozen_graph<T>;
 
 public:
+    graph() = default;
+
+    explicit graph(std::pmr::memory_resource *resource) :
+    nodes(resource), arena(std::make_shared<graph_arena>(resource)) {
+    }
+
+    // Copying a graph makes a deep copy:  new nodes and new edges with the
+    // same names and weights.  The default copy would have just copied the
+    // name->node table, leaving two graphs sharing (and, on destruction,
+    // both tearing down) the same nodes.  As with the std::pmr containers,
+    // the copy uses the default resource, not the original's.
+    graph(const graph &other) {
+        for (auto &node_pair: other.nodes) {
+            create_node(node_pair.first);
+        }
+        for (auto &node_pair: other.nodes) {
+            for (auto &edge: node_pair.second->out_edges) {
+                create_link(edge->start->name, edge->end->name, edge->weight);
+            }
+        }
+    }
+
+    graph &operator=(const graph &) = delete;
+
+    std::pmr::memory_resource *memory_resource() const {
+        return nodes.get_allocator().resource();
+    }
+
+    // How much memory the graph uses, and on what.  Some of it is estimated
+    // from the usual layouts (of a shared_ptr control block, and of a hash
+    // table entry) rather than measured, but closely enough for capacity
+    // planning, and it's exact about what grows with what.
+    graph_memory_usage memory_usage() const {
+        auto usage = graph_memory_usage();
+        using entry = typename decltype(nodes)::value_type;
+        using edge_list = decltype(graph_node<T>::out_edges);
+        usage.hash_table_bytes = nodes.bucket_count() * sizeof(void *) +
+                                 nodes.size() * (sizeof(void *) + sizeof(entry));
+        usage.node_bytes = nodes.size() * shared_object_bytes<graph_node<T>>();
+        for (auto &node_pair: nodes) {
+            auto &node = *node_pair.second;
+            usage.edge_bytes += node.out_edges.size() * shared_object_bytes<graph_edge<T>>();
+            usage.adjacency_bytes += (node.out_edges.capacity() + node.in_edges.capacity()) *
+                                     sizeof(typename edge_list::value_type);
+            usage.name_bytes += name_heap_bytes(node_pair.first) + name_heap_bytes(node.name);
+        }
+        usage.arena_bytes = arena->reserved_bytes();
+        return usage;
+    }
+
     void create_node(T name) {
         if(nodes.contains(name)) {
             throw std::domain_error("Node already exists"); 
         }
-        nodes[name] = std::make_shared<graph_node<T>>(name);
+        nodes[name] = std::allocate_shared<graph_node<T>>(
+            graph_arena_allocator<graph_node<T>>(arena), name, memory_resource());
     }
 
     void create_link(T start, T end, double weight) {
         if(!nodes.contains(start) || !nodes.contains(end)) {
             throw std::domain_error("Node does not exist");
         }
-        auto edge = std::make_shared<graph_edge<T>>(nodes[start], nodes[end],
+        auto edge = std::allocate_shared<graph_edge<T>>(
+            graph_arena_allocator<graph_edge<T>>(arena), nodes[start], nodes[end],
             weight);
-        nodes[start]->out_edges.insert(edge);
-        nodes[end]->in_edges.insert(edge); 
+        edge->out_index = nodes[start]->out_edges.size();
+        edge->in_index = nodes[end]->in_edges.size();
+        nodes[start]->out_edges.push_back(edge);
+        nodes[end]->in_edges.push_back(edge);
+    }
+
+    // Removing an edge costs O(out degree of start), just to find it:  once
+    // found, taking it out of both adjacency lists is constant time.
+    void remove_link(T start, T end) {
+        if(!nodes.contains(start) || !nodes.contains(end)) {
+            throw std::domain_error("Node does not exist");
+        }
+        auto &out_edges = nodes[start]->out_edges;
+        for (auto &edge: out_edges) {
+            if (edge->end->name == end) {
+                unlink(std::shared_ptr<graph_edge<T>>(edge));
+                return;
+            }
+        }
+        throw std::domain_error("Edge does not exist");
+    }
+
+    // Removes a node and every edge into or out of it, in O(degree).
+    void remove_node(T name) {
+        if(!nodes.contains(name)) {
+            throw std::domain_error("Node does not exist");
+        }
+        auto node = nodes[name];
+        while (!node->out_edges.empty()) {
+            unlink(std::shared_ptr<graph_edge<T>>(node->out_edges.back()));
+        }
+        while (!node->in_edges.empty()) {
+            unlink(std::shared_ptr<graph_edge<T>>(node->in_edges.back()));
+        }
+        nodes.erase(name);
     }
 
     // Note:  This doesn't DELETE the nodes and edges per se:
@@ -78,21 +237,50 @@ public:
     // can excee the lifetime of the enclosing graph.  IF we didn't use "smart"
     // pointers for all the nodes/edges we could end up with use after
     // free errors.
+    //
+    // Every node goes, so there's no need to carefully unlink each edge
+    // from both ends as remove_link does:  just empty every node's lists,
+    // one node after another.  And the memory itself isn't freed object by
+    // object, but all at once when the arena goes (which is once the last
+    // node or edge anyone still holds is gone).
     ~graph() {
-        for (auto node_pair: nodes) {
-            auto node = node_pair.second;
-            for (auto itr: node->out_edges) {
-                auto other = itr->end;
-                other->in_edges.erase(itr);
-            }
-            for (auto itr: node->in_edges) {
-                auto other = itr->start;
-                other->out_edges.erase(itr);
-            }
-            node->in_edges.clear();
-            node->out_edges.clear();
+        arena->release_all();
+        for (auto &node_pair: nodes) {
+            node_pair.second->out_edges.clear();
+            node_pair.second->in_edges.clear();
         }
     }
+
+private:
+    // What an allocate_shared object takes in the arena:  the object, plus
+    // the control block's two reference counts, vtable pointer and copy of
+    // the allocator.
+    template <class U>
+    static constexpr size_t shared_object_bytes() {
+        return graph_arena::round_up(sizeof(U) + 2 * sizeof(int) + sizeof(void *) +
+                                     sizeof(graph_arena_allocator<U>));
+    }
+
+    // Each node keeps its edges in plain vectors, and each edge remembers
+    // where it sits in both of them (out_index in its start's out_edges,
+    // in_index in its end's in_edges).  So an edge can be taken out without
+    // searching:  the last edge in the vector is moved into its slot, told
+    // its new index, and the vector shrinks by one ("swap and pop").  The
+    // order of a node's edges isn't meaningful, so nothing minds the move.
+    //
+    // edge is taken by value since the caller's reference may well be one
+    // of the very vector slots being overwritten.
+    static void unlink(std::shared_ptr<graph_edge<T>> edge) {
+        auto &out_edges = edge->start->out_edges;
+        out_edges[edge->out_index] = out_edges.back();
+        out_edges[edge->out_index]->out_index = edge->out_index;
+        out_edges.pop_back();
+
+        auto &in_edges = edge->end->in_edges;
+        in_edges[edge->in_index] = in_edges.back();
+        in_edges[edge->in_index]->in_index = edge->in_index;
+        in_edges.pop_back();
+    }
 };
 
 
@@ -102,6 +290,11 @@ public:
 // and the weight on the edge.
 template <class T>
 class graph_edge {
+private:
+    // Where this edge sits in start->out_edges and end->in_edges.
+    size_t out_index = 0;
+    size_t in_index = 0;
+    friend graph<T>;
 
 public:
     const double weight;
@@ -124,22 +317,28 @@ public:
 };
 
 // And the class for the node.  This is an adjacency list approach, where
-// each node has an unordered set of outward edges and a corresponding unordered
-// set of inward edges.  For our traversal we are only using the outEdges, but
-// we include both to enable this class to support other graph operations.
+// each node has a list of outward edges and a corresponding list of inward
+// edges.  For our traversal we are only using the outEdges, but we include
+// both to enable this class to support other graph operations (such as
+// removing a node, which has to find the edges pointing at it).
 template <class T>
 class graph_node {
 private:
-    std::unordered_set<std::shared_ptr<graph_edge<T>>> out_edges {};
-    std::unordered_set<std::shared_ptr<graph_edge<T>>> in_edges {};
-    friend dijkstra_traversal_iterator<T>;
+    std::pmr::vector<std::shared_ptr<graph_edge<T>>> out_edges;
+    std::pmr::vector<std::shared_ptr<graph_edge<T>>> in_edges;
+    template <class, bool> friend struct dijkstra_traversal_iterator;
+    friend dijkstra_coroutine<T>;
+    template <class, bool> friend class bfs_traversal_iterator;
+    template <class, bool> friend class dfs_traversal_iterator;
     friend graph<T>;
     friend graph_edge<T>;
+    friend frozen_graph<T>;
 
 public:
     const T name;
 
-    explicit graph_node(T nameIn) : name(nameIn){
+    explicit graph_node(T nameIn, std::pmr::memory_resource *resource = std::pmr::get_default_resource()) :
+    out_edges(resource), in_edges(resource), name(nameIn){
     }
 
 };
@@ -164,12 +363,16 @@ public:
 
 
 // This is the heart of the calculation.  In C++ iterators are somewhat
-// complex:  the root object needs to support begin() and end() which return
-// the iteration objects themselves.  The iteration object for the beginning needs
-// to support ++ (increment), * (get the current element) and != (is it at the end).
+// complex:  the root object needs to support begin() and end().  begin()
+// returns the iteration object itself, which needs to support ++ (increment)
+// and * (get the current element).  end() returns a "sentinel", and the
+// iteration object has to support == against the sentinel (is it at the end).
 //
-// The end object is effectively a dummy in this case, but it needs to be supported
-// anyway.  It will create a needless empty map in the process, but ah well.
+// Here the sentinel is an empty struct.  Older C++ required end() to return
+// the same type as begin(), which meant building a whole dummy iterator just
+// to have something to compare against.  Since C++20 the end can be a
+// different type, and comparing against it compiles down to checking
+// whether current_node is null.
 //
 // Basically, in C++, a loop like
 
@@ -185,38 +388,71 @@ public:
 
 // This means that * will be called for each time through the loop
 // and ++ will be called just before the ending is checked.
+//
+// The iterator also declares the handful of type names (value_type and so
+// on) that C++20's std::input_iterator concept asks for, so a traversal is
+// a proper range and works with the std::views adaptors, for example
+//
+// for(auto step : dijkstra_traversal<int>(g, 0)
+//                 | std::views::take_while([](auto &s) { return s->distance < 10; })) { ... }
+//
+// which lazily stops the traversal once it gets 10 away from the start.
+//
+// The traversal's scratch space (the working set, and the steps it hands
+// out) comes from the std::pmr::memory_resource given to the constructor,
+// if one is, so a request can keep all of it in a monotonic buffer and
+// throw it away in one go.  The steps can then only be used while that
+// resource is alive.
+//
+// dijkstra_traversal<T, true> also counts what it does into a
+// traversal_stats given to its constructor (see traversal_stats.hpp).  Here
+// the "frontier" is the nodes reached but not yet settled, and setup time
+// is building the working set.
+
+struct dijkstra_traversal_sentinel {
+};
+
+template <class T, bool Instrumented>
+struct dijkstra_traversal_iterator {
+    friend dijkstra_traversal<T, Instrumented>;
+public:
+    using iterator_concept = std::input_iterator_tag;
+    using value_type = std::shared_ptr<dijkstra_iteration_step<T>>;
+    using difference_type = std::ptrdiff_t;
 
-template <class T>
-struct dijkstra_traversal_iterator: std::input_iterator_tag {
-    friend dijkstra_traversal<T>;
 private:
-    std::unordered_map<std::shared_ptr<graph_node<T>>,
+    std::pmr::unordered_map<std::shared_ptr<graph_node<T>>,
                     std::shared_ptr<dijkstra_iteration_step<T>>> working_set;
     std::shared_ptr<dijkstra_iteration_step<T>> current_node = nullptr;
-    const std::shared_ptr<graph<T>> working_graph;
+    std::shared_ptr<const graph<T>> working_graph = nullptr;
+    [[no_unique_address]] traversal_recorder<Instrumented> recorder;
 
-    // The private constructor for the iterator.  If its the end it does nothing.
-    // If it is the beginning it creates the working set and initializes all the
-    // distances to +infinity, except for the start which it initializes to zero.
+    // The private constructor for the iterator.  It creates the working set
+    // and initializes all the distances to +infinity, except for the start
+    // which it initializes to zero.
     //
     // Once done it calls the intnernal iteration function once so that current_node
     // will be pointing to the first node in the traversal (which is the start node).
     // and the first iteration of the calculation will be executed.
-    dijkstra_traversal_iterator(std::shared_ptr<graph<T>> graph_ptr, T start, bool is_beginning) :
-    working_graph(graph_ptr) {
-        if(is_beginning) {
-            if(!working_graph->nodes.contains(start)) {
-                throw std::logic_error("Unable to find the node");
-            }
-            for(auto itr : working_graph->nodes) {
-                auto element = std::make_shared<dijkstra_iteration_step<T>>(itr.second);
-                if (itr.first == start) {
-                    element->distance = 0;
-                }
-                working_set[itr.second] = element;
+    dijkstra_traversal_iterator(std::shared_ptr<const graph<T>> graph_ptr, T start,
+                                traversal_recorder<Instrumented> recorderIn,
+                                std::pmr::memory_resource *resource) :
+    working_set(resource), working_graph(graph_ptr), recorder(recorderIn) {
+        if(!working_graph->nodes.contains(start)) {
+            throw std::logic_error("Unable to find the node");
+        }
+        auto started = recorder.now();
+        for(auto itr : working_graph->nodes) {
+            auto element = std::allocate_shared<dijkstra_iteration_step<T>>(
+                std::pmr::polymorphic_allocator<dijkstra_iteration_step<T>>(resource), itr.second);
+            if (itr.first == start) {
+                element->distance = 0;
+                recorder.pushed();
             }
-            this->iter();
+            working_set[itr.second] = element;
         }
+        recorder.add_setup_time(started);
+        this->iter();
     }
 
     // And this is the heart of the iteration step.  It clears the current node
@@ -231,6 +467,12 @@ private:
     // distance.  If the new distance would be less it reduces the distance and updates
     // the previous node on the record.
     void iter() {
+        auto started = recorder.now();
+        search();
+        recorder.add_search_time(started);
+    }
+
+    void search() {
         current_node = nullptr;
         if (working_set.size() == 0) {
             return;
@@ -248,10 +490,18 @@ private:
             current_node = nullptr;
             return;
         }
+        recorder.popped();
+        recorder.settled();
         for (auto itr : current_node->current->out_edges) {
+            recorder.relaxed();
             if(working_set.contains(itr->end)) {
                 auto distance = current_node->distance + itr->weight;
                 if(distance < working_set[itr->end]->distance) {
+                    if(working_set[itr->end]->distance == HUGE_VAL) {
+                        recorder.pushed();
+                    } else {
+                        recorder.decreased_key();
+                    }
                     working_set[itr->end]->distance = distance;
                     working_set[itr->end]->previous = current_node->current;
                 }
@@ -260,24 +510,37 @@ private:
     }
 
 public:
+    // An iterator that isn't part of any traversal, which is already at
+    // the end.  The ranges library wants iterators to be constructible
+    // this way.
+    dijkstra_traversal_iterator() = default;
+
     // The ++ operator is the part that calls the iterator to
     // make sure the current node is available.
-    void operator++() {
+    dijkstra_traversal_iterator &operator++() {
+        iter();
+        return *this;
+    }
+
+    void operator++(int) {
         iter();
     }
 
-    // And the * operator returns the current node.
-    std::shared_ptr<dijkstra_iteration_step<T>> operator*() {
+    // And the * operator returns the current node.  It returns a reference
+    // rather than a copy of the shared_ptr, so that just looking at the
+    // current step doesn't have to touch the reference count.
+    const std::shared_ptr<dijkstra_iteration_step<T>> &operator*() const {
         return current_node;
     }
 
     // And this is "is there still data left".  The contract for the
     // iterator says that ++ is called AFTER the data is accessed, so
     // we know it will be executed in the loop in order: If there is
-    // no data left the != operation will be checked before the next call
-    // to *.
-    bool operator!=(dijkstra_traversal_iterator &) {
-        return current_node != nullptr;
+    // no data left the == operation will be checked before the next call
+    // to *.  (C++20 works out != and the sentinel == iterator versions
+    // from this one.)
+    bool operator==(dijkstra_traversal_sentinel) const {
+        return current_node == nullptr;
     }
 };
 
@@ -285,7 +548,11 @@ public:
 // And this is the basic shell for the above iterator.
 // The constructor accepts the graph and the starting node,
 // while the object itself returns the iterator using begin()
-// and end().
+// and the sentinel using end().
+//
+// It is also a std::ranges view:  it only holds a pointer to the graph
+// and the start, so it is cheap to copy, which is what lets the
+// std::views adaptors wrap it without copying any traversal state.
 //
 // The reason why C++ requires returing TWO iterators, while
 // just about every other language with iteration primatives uses
@@ -293,29 +560,31 @@ public:
 // designed to do things like iterate over an array's internal storage,
 // and the start and end were just pointers to the first element and one plus
 // the last element, and the ++ was just doing pointer arithmatic.
-template <class T>
-class dijkstra_traversal {
+template <class T, bool Instrumented>
+class dijkstra_traversal : public std::ranges::view_interface<dijkstra_traversal<T, Instrumented>> {
 
 public:
-    const std::shared_ptr<graph<T>> working_graph;
-    const T start;
-    dijkstra_traversal(std::shared_ptr<graph<T>> g, T s) : working_graph(g), start(s){
-    }
-
-    dijkstra_traversal_iterator<T> begin() {
-        return dijkstra_traversal_iterator<T>(working_graph, start, true);
+    std::shared_ptr<const graph<T>> working_graph;
+    T start;
+    [[no_unique_address]] traversal_recorder<Instrumented> recorder;
+    std::pmr::memory_resource *resource;
+
+    dijkstra_traversal(std::shared_ptr<const graph<T>> g, T s,
+                       std::pmr::memory_resource *resourceIn = std::pmr::get_default_resource())
+    requires (!Instrumented) : working_graph(g), start(s), resource(resourceIn){
     }
 
-    dijkstra_traversal_iterator<T> begin() const {
-        return dijkstra_traversal_iterator<T>(working_graph, start, true);
+    dijkstra_traversal(std::shared_ptr<const graph<T>> g, T s, traversal_stats &stats,
+                       std::pmr::memory_resource *resourceIn = std::pmr::get_default_resource())
+    requires Instrumented : working_graph(g), start(s), recorder(stats), resource(resourceIn) {
     }
 
-    dijkstra_traversal_iterator<T> end() {
-        return dijkstra_traversal_iterator<T>(working_graph, start, false);
+    dijkstra_traversal_iterator<T, Instrumented> begin() const {
+        return dijkstra_traversal_iterator<T, Instrumented>(working_graph, start, recorder, resource);
     }
 
-    dijkstra_traversal_iterator<T> end() const {
-        return dijkstra_traversal_iterator<T>(working_graph, start, false);
+    dijkstra_traversal_sentinel end() const {
+        return {};
     }
 };
 
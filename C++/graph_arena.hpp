@@ -0,0 +1,177 @@
+#ifndef GRAPH_ARENA_H
+#define GRAPH_ARENA_H
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <memory_resource>
+#include <new>
+#include <vector>
+
+// Where a graph's nodes and edges live.
+//
+// Every node and edge of a graph<T> is its own small heap object, and with
+// the ordinary allocator tearing down a big graph means one free() per
+// object, in whatever order the objects happen to be reached:  a cache
+// miss and a trip through the allocator for every single edge.
+//
+// So instead a graph carves its nodes and edges out of large chunks it
+// owns (a "bump" or arena allocator:  allocating is just moving a pointer
+// along the current chunk), and when the graph is gone the chunks are
+// handed back to the system in one go, a few hundred objects per free().
+//
+// The catch is that nodes can outlive their graph (a traversal step holds
+// shared_ptrs to nodes), so the arena can't simply be freed along with the
+// graph.  Instead every node and edge holds a reference to the arena (the
+// allocator is stored in its shared_ptr control block), and the arena goes
+// away when the last of them does.
+//
+// Objects freed while the graph is still alive (remove_link, remove_node)
+// go on a free list for their size, and the next object of that size
+// reuses the space, so a graph that sees lots of churn doesn't keep
+// growing.  Once the graph itself is being torn down, release_all() turns
+// that bookkeeping off, and frees cost nothing at all.
+//
+// The chunks themselves come from a std::pmr::memory_resource (the default
+// resource unless the graph was given one), which has to outlive the arena:
+// that is, outlive every node and edge, including any a traversal step is
+// still holding on to.
+
+class graph_arena {
+private:
+    static constexpr size_t chunk_size = 64 * 1024;
+    // Everything is aligned (and rounded up) to this, which is enough for
+    // anything a node or an edge holds.
+    static constexpr size_t alignment = alignof(std::max_align_t);
+
+    struct free_block {
+        free_block *next;
+    };
+
+    struct chunk {
+        std::byte *data;
+        size_t size;
+    };
+
+    std::pmr::memory_resource *upstream;
+    std::vector<chunk> chunks;
+    size_t reserved = 0;
+    std::byte *position = nullptr;
+    size_t remaining = 0;
+
+    // free_lists[k] holds freed blocks of (k + 1) * alignment bytes.  Only
+    // small sizes are reused;  anything bigger is rare and just left.
+    static constexpr size_t free_list_count = 16;
+    free_block *free_lists[free_list_count] = {};
+    std::mutex free_list_mutex;
+    std::atomic<bool> releasing = false;
+
+public:
+    // How much space an allocation of this many bytes actually takes.
+    static constexpr size_t round_up(size_t bytes) {
+        return (bytes + alignment - 1) / alignment * alignment;
+    }
+
+    explicit graph_arena(std::pmr::memory_resource *upstreamIn = std::pmr::get_default_resource()) :
+    upstream(upstreamIn) {
+    }
+
+    graph_arena(const graph_arena &) = delete;
+    graph_arena &operator=(const graph_arena &) = delete;
+
+    ~graph_arena() {
+        for(auto &c : chunks) {
+            upstream->deallocate(c.data, c.size, alignment);
+        }
+    }
+
+    void *allocate(size_t bytes) {
+        bytes = round_up(bytes);
+        auto list = bytes / alignment - 1;
+        if(list < free_list_count) {
+            std::lock_guard lock(free_list_mutex);
+            if(free_lists[list] != nullptr) {
+                auto block = free_lists[list];
+                free_lists[list] = block->next;
+                return block;
+            }
+        }
+        if(bytes > chunk_size / 4) {
+            // Too big to be worth packing:  give it a chunk of its own.
+            return new_chunk(bytes);
+        }
+        if(bytes > remaining) {
+            position = new_chunk(chunk_size);
+            remaining = chunk_size;
+        }
+        auto result = position;
+        position += bytes;
+        remaining -= bytes;
+        return result;
+    }
+
+    void deallocate(void *pointer, size_t bytes) {
+        if(releasing.load(std::memory_order_relaxed)) {
+            return;
+        }
+        auto list = round_up(bytes) / alignment - 1;
+        if(list < free_list_count) {
+            std::lock_guard lock(free_list_mutex);
+            auto block = static_cast<free_block *>(pointer);
+            block->next = free_lists[list];
+            free_lists[list] = block;
+        }
+    }
+
+    // From now on freed space isn't reused:  the owner is going away, and
+    // everything will be freed in bulk when the last reference to the
+    // arena does.
+    void release_all() {
+        releasing.store(true, std::memory_order_relaxed);
+    }
+
+    // Bytes held in chunks, whether in use or not.
+    size_t reserved_bytes() const {
+        return reserved;
+    }
+
+private:
+    std::byte *new_chunk(size_t bytes) {
+        chunks.reserve(chunks.size() + 1);
+        auto data = static_cast<std::byte *>(upstream->allocate(bytes, alignment));
+        chunks.push_back({data, bytes});
+        reserved += bytes;
+        return data;
+    }
+};
+
+// A standard allocator over a shared graph_arena, for std::allocate_shared.
+template <class U>
+struct graph_arena_allocator {
+    using value_type = U;
+
+    std::shared_ptr<graph_arena> arena;
+
+    explicit graph_arena_allocator(std::shared_ptr<graph_arena> arenaIn) : arena(std::move(arenaIn)) {
+    }
+
+    template <class V>
+    graph_arena_allocator(const graph_arena_allocator<V> &other) : arena(other.arena) {
+    }
+
+    U *allocate(size_t count) {
+        return static_cast<U *>(arena->allocate(count * sizeof(U)));
+    }
+
+    void deallocate(U *pointer, size_t count) {
+        arena->deallocate(pointer, count * sizeof(U));
+    }
+
+    template <class V>
+    bool operator==(const graph_arena_allocator<V> &other) const {
+        return arena == other.arena;
+    }
+};
+
+#endif //GRAPH_ARENA_H
@@ -0,0 +1,99 @@
+#include "graph_generators.hpp"
+
+#include <cassert>
+#include <iostream>
+#include <set>
+
+#include "dijkstra_workspace.hpp"
+
+// Checks that each generator gives what it promises:  valid, positive,
+// unique edges with no self loops, the same graph for the same seed, and
+// the shape expected of it.
+
+static void check_edges(const generated_graph &g) {
+    auto seen = std::set<std::pair<node_id, node_id>>();
+    for(auto &e : g.edges) {
+        assert(e.start < g.node_count && e.end < g.node_count);
+        assert(e.start != e.end && e.weight > 0);
+        assert(seen.insert({e.start, e.end}).second);
+    }
+}
+
+static bool same(const generated_graph &a, const generated_graph &b) {
+    return a.node_count == b.node_count &&
+           std::equal(a.edges.begin(), a.edges.end(), b.edges.begin(), b.edges.end(),
+                      [](const frozen_edge &x, const frozen_edge &y) {
+                          return x.start == y.start && x.end == y.end && x.weight == y.weight;
+                      });
+}
+
+static size_t max_degree(const generated_graph &g) {
+    auto degree = std::vector<size_t>(g.node_count, 0);
+    for(auto &e : g.edges) {
+        degree[e.start]++;
+        degree[e.end]++;
+    }
+    return *std::max_element(degree.begin(), degree.end());
+}
+
+void testGraphGenerators() {
+    std::cerr << "Initializing graph generator tests" << std::endl;
+
+    auto grid = grid_graph(30, 40);
+    check_edges(grid);
+    assert(grid.node_count == 1200);
+    assert(grid.edges.size() == 2 * (30 * 39 + 40 * 29));
+    assert(max_degree(grid) == 8);
+
+    // Every edge within the radius, weighted by distance, and both ways;
+    // and with the radius left to the generator, about the degree asked for.
+    auto radius = 0.05;
+    auto geometric = random_geometric_graph(1000, 0, 3, radius);
+    check_edges(geometric);
+    auto pairs = std::set<std::pair<node_id, node_id>>();
+    for(auto &e : geometric.edges) {
+        assert(e.weight <= radius);
+        pairs.insert({e.start, e.end});
+    }
+    for(auto &e : geometric.edges) {
+        assert(pairs.contains({e.end, e.start}));
+    }
+    auto sized = random_geometric_graph(20000, 8);
+    check_edges(sized);
+    auto average = double(sized.edges.size()) / sized.node_count;
+    assert(average > 6 && average < 9);
+
+    auto er = erdos_renyi_graph(5000, 8);
+    check_edges(er);
+    assert(er.edges.size() > 5000 * 7.9);
+
+    // The skewed generators should have hubs far above the average degree,
+    // which uniform random graphs don't.
+    auto rmat = rmat_graph(14, 8);
+    check_edges(rmat);
+    assert(rmat.node_count == 1 << 14);
+    assert(max_degree(rmat) > 10 * max_degree(er));
+    auto power = power_law_graph(20000, 8, 2.2);
+    check_edges(power);
+    assert(max_degree(power) > 10 * max_degree(er));
+
+    assert(same(rmat_graph(10, 4, 7), rmat_graph(10, 4, 7)));
+    assert(!same(rmat_graph(10, 4, 7), rmat_graph(10, 4, 8)));
+    assert(same(power_law_graph(1000, 4, 2.5, 5), power_law_graph(1000, 4, 2.5, 5)));
+
+    // And the two ways of building them agree:  the same distances from the
+    // same source, over the same set of reached nodes.
+    auto small = erdos_renyi_graph(200, 3);
+    auto frozen = freeze(small);
+    auto built = build_graph(small);
+    assert(frozen.edge_count() == small.edges.size());
+    auto workspace = dijkstra_workspace();
+    workspace.run(frozen, frozen.id(0));
+    auto steps = size_t(0);
+    for(auto step : dijkstra_traversal<std::uint64_t>(built, 0)) {
+        assert(workspace.distance(frozen.id(step->current->name)) == step->distance);
+        steps++;
+    }
+    assert(steps == workspace.settled_count());
+    assert(steps > 1);
+}
@@ -0,0 +1,252 @@
+#ifndef GRAPH_GENERATORS_H
+#define GRAPH_GENERATORS_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <numbers>
+#include <random>
+#include <stdexcept>
+#include <vector>
+
+#include "frozen_graph.hpp"
+#include "graph.hpp"
+
+// Synthetic graphs for benchmarks and tests, each imitating a kind of
+// graph that shows up in practice, since they stress an implementation
+// differently:
+//
+// - rmat_graph:  R-MAT (Chakrabarti et al, 2004), the generator behind the
+//   Graph500 benchmark.  Skewed degrees and small world structure, like
+//   social and web graphs.
+// - grid_graph:  a 2D grid.  Every node has degree 4 and paths are long,
+//   like road networks and meshes.
+// - random_geometric_graph:  points scattered in the unit square, with
+//   every pair closer than a radius connected, weighted by distance.  Also
+//   road-like, but irregular.
+// - erdos_renyi_graph:  edges between uniformly random pairs.  No structure
+//   at all, so no locality to exploit.
+// - power_law_graph:  a Chung-Lu graph, random apart from node degrees
+//   following a power law with the given exponent (2 to 3 is typical).
+//
+// They're all deterministic for a given seed, and give directed edges
+// with positive weights and no self loops or parallel edges (so that any
+// of them can also be built as a graph<T>).  Nodes are numbered densely
+// from 0, and the undirected kinds (grid, geometric) get an edge each way.
+
+struct generated_graph {
+    node_id node_count = 0;
+    std::vector<frozen_edge> edges;
+};
+
+// Sorts the edges, and drops self loops and all but one of any parallel
+// edges.
+inline void remove_duplicate_edges(std::vector<frozen_edge> &edges) {
+    std::sort(edges.begin(), edges.end(), [](const frozen_edge &a, const frozen_edge &b) {
+        return a.start != b.start ? a.start < b.start : a.end < b.end;
+    });
+    auto kept = std::unique(edges.begin(), edges.end(), [](const frozen_edge &a, const frozen_edge &b) {
+        return a.start == b.start && a.end == b.end;
+    });
+    edges.erase(kept, edges.end());
+    std::erase_if(edges, [](const frozen_edge &e) { return e.start == e.end; });
+}
+
+inline generated_graph rmat_graph(unsigned scale, unsigned edge_factor, std::uint64_t seed = 1,
+                                  double a = 0.57, double b = 0.19, double c = 0.19) {
+    if(scale >= 32 || a + b + c >= 1) {
+        throw std::domain_error("Bad R-MAT parameters");
+    }
+    auto result = generated_graph {node_id(1) << scale, {}};
+    auto rng = std::mt19937_64(seed);
+    auto unit = std::uniform_real_distribution<double>(0, 1);
+    auto weight = std::uniform_real_distribution<double>(1, 100);
+    // R-MAT puts all the high degree nodes at small ids;  scrambling the ids
+    // (as Graph500 does) keeps that from looking like locality.
+    auto scramble = std::vector<node_id>(result.node_count);
+    for(node_id i = 0; i < result.node_count; ++i) {
+        scramble[i] = i;
+    }
+    std::shuffle(scramble.begin(), scramble.end(), rng);
+    auto m = size_t(edge_factor) << scale;
+    result.edges.reserve(m);
+    for(size_t k = 0; k < m; ++k) {
+        // Each level picks one quadrant of the adjacency matrix, which fixes
+        // one more bit of the start and end.
+        node_id start = 0, end = 0;
+        for(unsigned bit = 0; bit < scale; ++bit) {
+            auto r = unit(rng);
+            start = start << 1 | (r >= a + b);
+            end = end << 1 | ((r >= a && r < a + b) || r >= a + b + c);
+        }
+        result.edges.push_back({scramble[start], scramble[end], weight(rng)});
+    }
+    remove_duplicate_edges(result.edges);
+    return result;
+}
+
+inline generated_graph grid_graph(node_id rows, node_id columns, std::uint64_t seed = 1) {
+    if(std::uint64_t(rows) * columns >= no_node) {
+        throw std::domain_error("Grid too big");
+    }
+    auto result = generated_graph {rows * columns, {}};
+    auto rng = std::mt19937_64(seed);
+    auto weight = std::uniform_real_distribution<double>(1, 10);
+    result.edges.reserve(size_t(result.node_count) * 4);
+    for(node_id row = 0; row < rows; ++row) {
+        for(node_id column = 0; column < columns; ++column) {
+            auto u = row * columns + column;
+            if(column + 1 < columns) {
+                result.edges.push_back({u, u + 1, weight(rng)});
+                result.edges.push_back({u + 1, u, weight(rng)});
+            }
+            if(row + 1 < rows) {
+                result.edges.push_back({u, u + columns, weight(rng)});
+                result.edges.push_back({u + columns, u, weight(rng)});
+            }
+        }
+    }
+    return result;
+}
+
+// radius 0 picks the radius that gives about average_degree neighbours.
+inline generated_graph random_geometric_graph(node_id nodes, double average_degree = 8, std::uint64_t seed = 1,
+                                              double radius = 0) {
+    if(radius <= 0) {
+        radius = std::sqrt(average_degree / (std::numbers::pi * nodes));
+    }
+    auto result = generated_graph {nodes, {}};
+    auto rng = std::mt19937_64(seed);
+    auto unit = std::uniform_real_distribution<double>(0, 1);
+    auto x = std::vector<double>(nodes);
+    auto y = std::vector<double>(nodes);
+    for(node_id i = 0; i < nodes; ++i) {
+        x[i] = unit(rng);
+        y[i] = unit(rng);
+    }
+    // Bucket the points into cells (at least) one radius across, so that
+    // each point only needs comparing with the points in its own and the 8
+    // cells around it.  There's no point in many more cells than points.
+    auto cells = std::max<size_t>(1, std::min<size_t>(size_t(1 / radius), size_t(std::sqrt(double(nodes))) + 1));
+    auto cell_of = [&](double v) { return std::min(cells - 1, size_t(v * double(cells))); };
+    auto offsets = std::vector<size_t>(cells * cells + 1, 0);
+    for(node_id i = 0; i < nodes; ++i) {
+        offsets[cell_of(y[i]) * cells + cell_of(x[i]) + 1]++;
+    }
+    for(size_t k = 0; k < cells * cells; ++k) {
+        offsets[k + 1] += offsets[k];
+    }
+    auto members = std::vector<node_id>(nodes);
+    auto fill = std::vector<size_t>(offsets.begin(), offsets.end() - 1);
+    for(node_id i = 0; i < nodes; ++i) {
+        members[fill[cell_of(y[i]) * cells + cell_of(x[i])]++] = i;
+    }
+    for(node_id i = 0; i < nodes; ++i) {
+        auto row = cell_of(y[i]);
+        auto column = cell_of(x[i]);
+        for(auto r = row == 0 ? 0 : row - 1; r <= std::min(cells - 1, row + 1); ++r) {
+            for(auto c = column == 0 ? 0 : column - 1; c <= std::min(cells - 1, column + 1); ++c) {
+                for(auto k = offsets[r * cells + c]; k < offsets[r * cells + c + 1]; ++k) {
+                    auto j = members[k];
+                    auto distance = std::hypot(x[i] - x[j], y[i] - y[j]);
+                    if(j != i && distance <= radius) {
+                        // Coincident points would give a zero weight.
+                        result.edges.push_back({i, j, std::max(distance, 1e-12)});
+                    }
+                }
+            }
+        }
+    }
+    return result;
+}
+
+inline generated_graph erdos_renyi_graph(node_id nodes, double average_degree = 8, std::uint64_t seed = 1) {
+    auto result = generated_graph {nodes, {}};
+    auto rng = std::mt19937_64(seed);
+    auto pick = std::uniform_int_distribution<node_id>(0, nodes - 1);
+    auto weight = std::uniform_real_distribution<double>(1, 100);
+    auto m = size_t(average_degree * nodes);
+    result.edges.reserve(m);
+    for(size_t k = 0; k < m; ++k) {
+        result.edges.push_back({pick(rng), pick(rng), weight(rng)});
+    }
+    remove_duplicate_edges(result.edges);
+    return result;
+}
+
+inline generated_graph power_law_graph(node_id nodes, double average_degree = 8, double exponent = 2.5,
+                                       std::uint64_t seed = 1) {
+    if(!(exponent > 2)) {
+        throw std::domain_error("Power law exponent must be above 2");
+    }
+    auto result = generated_graph {nodes, {}};
+    auto rng = std::mt19937_64(seed);
+    // Chung-Lu:  node i gets an expected degree proportional to
+    // (i + 1)^(-1 / (exponent - 1)), which makes the degrees follow the
+    // power law, and both ends of every edge are picked in proportion to
+    // those.  Node ids are shuffled so the hubs aren't all at the start.
+    auto cumulative = std::vector<double>(nodes);
+    double total = 0;
+    for(node_id i = 0; i < nodes; ++i) {
+        total += std::pow(double(i + 1), -1 / (exponent - 1));
+        cumulative[i] = total;
+    }
+    auto scramble = std::vector<node_id>(nodes);
+    for(node_id i = 0; i < nodes; ++i) {
+        scramble[i] = i;
+    }
+    std::shuffle(scramble.begin(), scramble.end(), rng);
+    auto unit = std::uniform_real_distribution<double>(0, total);
+    auto pick = [&]() {
+        auto itr = std::upper_bound(cumulative.begin(), cumulative.end(), unit(rng));
+        return scramble[std::min<size_t>(itr - cumulative.begin(), nodes - 1)];
+    };
+    auto weight = std::uniform_real_distribution<double>(1, 100);
+    auto m = size_t(average_degree * nodes);
+    result.edges.reserve(m);
+    for(size_t k = 0; k < m; ++k) {
+        auto start = pick();
+        result.edges.push_back({start, pick(), weight(rng)});
+    }
+    remove_duplicate_edges(result.edges);
+    return result;
+}
+
+// Replaces every weight with a whole number from 1 to levels, for tests
+// that want plenty of ties between equally long paths.
+inline void use_whole_weights(generated_graph &generated, unsigned levels) {
+    for(auto &e : generated.edges) {
+        e.weight = 1 + std::fmod(std::floor(e.weight), double(levels));
+    }
+}
+
+// A generated graph as a frozen_graph, with node i named name(i) (by
+// default, just i).
+template <class T = std::uint64_t, class Name = std::identity>
+frozen_graph<T> freeze(const generated_graph &generated, Name &&name = {}) {
+    auto names = std::vector<T>();
+    names.reserve(generated.node_count);
+    for(node_id i = 0; i < generated.node_count; ++i) {
+        names.push_back(T(name(i)));
+    }
+    return frozen_graph<T>(std::move(names), generated.edges);
+}
+
+// And as a graph<T>, named the same way.
+template <class T = std::uint64_t, class Name = std::identity>
+std::shared_ptr<graph<T>> build_graph(const generated_graph &generated, Name &&name = {}) {
+    auto g = std::make_shared<graph<T>>();
+    for(node_id i = 0; i < generated.node_count; ++i) {
+        g->create_node(T(name(i)));
+    }
+    for(auto &e : generated.edges) {
+        g->create_link(T(name(e.start)), T(name(e.end)), e.weight);
+    }
+    return g;
+}
+
+void testGraphGenerators();
+
+#endif //GRAPH_GENERATORS_H
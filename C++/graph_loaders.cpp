@@ -0,0 +1,116 @@
+#include "graph_loaders.hpp"
+
+#include <cassert>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <tuple>
+
+// Parses small files in each format and checks the edges that come out,
+// then a generated edge list big enough to be split into many chunks,
+// checked against the edges that went into it.  Then checks that malformed
+// files are turned away.
+
+using named_edge = std::tuple<std::uint64_t, std::uint64_t, double>;
+
+static std::vector<named_edge> edges_of(const frozen_graph<std::uint64_t> &g) {
+    auto edges = std::vector<named_edge>();
+    for(node_id u = 0; u < g.node_count(); ++u) {
+        g.for_each_out_edge(u, [&](node_id v, double w) {
+            edges.emplace_back(g.name(u), g.name(v), w);
+        });
+    }
+    std::sort(edges.begin(), edges.end());
+    return edges;
+}
+
+static bool rejected(const char *text, frozen_graph<std::uint64_t> (*parse)(std::string_view, thread_pool &),
+                     thread_pool &pool) {
+    try {
+        parse(text, pool);
+    } catch(std::domain_error &) {
+        return true;
+    }
+    return false;
+}
+
+void testGraphLoaders() {
+    std::cerr << "Initializing graph loader tests" << std::endl;
+    auto pool = thread_pool(4);
+
+    auto list = parse_edge_list("# a comment\n"
+                                "10 20 1.5\n"
+                                "20 30\r\n"
+                                "\n"
+                                "% another comment\n"
+                                "30 10 2e1\n"
+                                "10 30 7", pool);
+    assert(list.node_count() == 3);
+    assert((edges_of(list) == std::vector<named_edge> {
+        {10, 20, 1.5}, {10, 30, 7}, {20, 30, 1}, {30, 10, 20}}));
+
+    auto dimacs = parse_dimacs("c a comment\n"
+                               "p sp 4 3\n"
+                               "c another comment\n"
+                               "a 1 2 5\n"
+                               "a 2 3 0.25\n"
+                               "a 4 1 3\n", pool);
+    assert(dimacs.node_count() == 4);
+    assert(dimacs.name(dimacs.id(4)) == 4);
+    assert((edges_of(dimacs) == std::vector<named_edge> {{1, 2, 5}, {2, 3, 0.25}, {4, 1, 3}}));
+
+    // Node 3 has no neighbours, so its line is blank.
+    auto metis = parse_metis("% a comment\n"
+                             "4 2 001\n"
+                             "2 4 4 2\n"
+                             "1 4\n"
+                             "\n"
+                             "1 2\n", pool);
+    assert(metis.node_count() == 4);
+    assert((edges_of(metis) == std::vector<named_edge> {
+        {1, 2, 4}, {1, 4, 2}, {2, 1, 4}, {4, 1, 2}}));
+    // Three node weights per node (fmt 010, ncon 3), unweighted edges.
+    auto weighted_nodes = parse_metis("2 1 010 3\n"
+                                      "5 6 7 2\n"
+                                      "1 1 1 1\n", pool);
+    assert((edges_of(weighted_nodes) == std::vector<named_edge> {{1, 2, 1}, {2, 1, 1}}));
+
+    // Big enough to be split into lots of chunks, written out and loaded
+    // back through a mapped file.
+    auto expected = std::vector<named_edge>();
+    for(std::uint64_t i = 0; i < 50000; ++i) {
+        expected.emplace_back(i * 3, (i * 7919) % 150000, double(i % 100 + 1) / 4);
+    }
+    auto path = (std::filesystem::temp_directory_path() / "graph_test_edges.txt").string();
+    {
+        auto out = std::ofstream(path);
+        for(auto &[start, end, weight] : expected) {
+            out << start << ' ' << end << ' ' << weight << '\n';
+        }
+    }
+    auto loaded = load_edge_list(path, pool);
+    std::filesystem::remove(path);
+    std::sort(expected.begin(), expected.end());
+    assert(edges_of(loaded) == expected);
+
+    assert(rejected("1 2 3 4\n", parse_edge_list, pool));
+    assert(rejected("1 x\n", parse_edge_list, pool));
+    assert(rejected("1 2 0\n", parse_edge_list, pool));
+    assert(rejected("a 1 2 3\n", parse_dimacs, pool));
+    assert(rejected("p sp 2 1\na 1 3 1\n", parse_dimacs, pool));
+    assert(rejected("p sp 2 2\na 1 2 1\n", parse_dimacs, pool));
+    assert(rejected("p sp 2 1\nx 1 2 1\n", parse_dimacs, pool));
+    assert(rejected("2 1\n2\n", parse_metis, pool));
+    assert(rejected("2 1\n2\n3\n", parse_metis, pool));
+    assert(rejected("2 2\n2\n1\n", parse_metis, pool));
+    assert(rejected("2 1 001\n2\n1 1\n", parse_metis, pool));
+    // Numbers past 2^64 - 1 are rejected, not wrapped round:  this one would
+    // wrap to node 1, which would pass the range check.
+    assert(rejected("p sp 2 1\na 18446744073709551617 2 1\n", parse_dimacs, pool));
+    assert(rejected("18446744073709551616 1\n", parse_edge_list, pool));
+    assert(rejected("1 99999999999999999999999\n", parse_edge_list, pool));
+    // The largest value still fits, and a huge whole weight goes through
+    // the floating point path instead.
+    auto largest = parse_edge_list("18446744073709551615 1 18446744073709551617\n", pool);
+    assert((edges_of(largest) == std::vector<named_edge> {{18446744073709551615u, 1, 18446744073709551617.0}}));
+}
@@ -0,0 +1,444 @@
+#ifndef GRAPH_LOADERS_H
+#define GRAPH_LOADERS_H
+
+#include <algorithm>
+#include <charconv>
+#include <cstdint>
+#include <limits>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "frozen_graph.hpp"
+#include "mapped_file.hpp"
+#include "thread_pool.hpp"
+
+// Loaders for the common text formats for graphs:
+//
+// - Edge lists:  one edge per line, "start end" or "start end weight",
+//   with node ids as unsigned integers.  A missing weight means 1.  Lines
+//   starting with # or % are comments.  The node ids can be anything (they
+//   don't have to be dense), and become the node names.
+//
+// - DIMACS shortest path (.gr) files, from the 9th DIMACS challenge:  a
+//   "p sp <nodes> <arcs>" line, then one "a <start> <end> <weight>" line
+//   per arc, with nodes numbered from 1.  Lines starting with c are
+//   comments.
+//
+// - METIS graph files:  a "<nodes> <edges> [fmt [ncon]]" header, then one
+//   line per node (node i on line i, numbered from 1) listing its
+//   neighbours, each followed by the edge's weight if fmt says edges are
+//   weighted.  Lines starting with % are comments.  METIS graphs are
+//   undirected and every edge is listed from both ends, so each listing
+//   becomes one directed edge.
+//
+// All three produce a frozen_graph<std::uint64_t> whose names are the ids
+// used in the file, built directly with frozen_graph's bulk constructor,
+// so there's no create_node or create_link per edge.
+//
+// For speed, the text is split into chunks (at line boundaries) which are
+// parsed in parallel on a thread pool, and the numbers are parsed by hand
+// rather than through iostreams, which are slow (locale handling, virtual
+// calls and error state on every single number).  The parse_ functions take
+// the text itself, and the load_ functions map a file and parse that.
+//
+// Malformed input throws std::domain_error, quoting the offending line.
+
+// Reads through one chunk of text.  Everything here is small enough to be
+// inlined into the parsing loops.
+struct text_cursor {
+    const char *p;
+    const char *end;
+
+    bool done() const {
+        return p == end;
+    }
+
+    // Skips spaces and tabs (and the \r of a \r\n line ending).
+    void skip_blanks() {
+        while(p != end && (*p == ' ' || *p == '\t' || *p == '\r')) {
+            ++p;
+        }
+    }
+
+    bool at_line_end() {
+        skip_blanks();
+        return p == end || *p == '\n';
+    }
+
+    void skip_line() {
+        while(p != end && *p != '\n') {
+            ++p;
+        }
+        if(p != end) {
+            ++p;
+        }
+    }
+
+    // The line containing the cursor, for error messages.
+    std::string_view line(const char *text_start) const {
+        auto start = p;
+        while(start != text_start && start[-1] != '\n') {
+            --start;
+        }
+        auto stop = p;
+        while(stop != end && *stop != '\n') {
+            ++stop;
+        }
+        return {start, size_t(stop - start)};
+    }
+
+    // Digits are accumulated in a plain loop with no per-digit branching
+    // beyond the loop test and the overflow check, which compilers turn
+    // into tight code.  A number too big for 64 bits is rejected, rather
+    // than wrapping round to something that passes the callers' range
+    // checks.
+    bool read_uint(std::uint64_t &value) {
+        skip_blanks();
+        if(p == end || unsigned(*p - '0') > 9) {
+            return false;
+        }
+        std::uint64_t result = 0;
+        while(p != end && unsigned(*p - '0') <= 9) {
+            auto digit = unsigned(*p - '0');
+            if(result > (std::numeric_limits<std::uint64_t>::max() - digit) / 10) {
+                return false;
+            }
+            result = result * 10 + digit;
+            ++p;
+        }
+        value = result;
+        return true;
+    }
+
+    // Weights in these formats are nearly always whole numbers, so those
+    // take the integer path.  Anything else (a fraction, an exponent) goes
+    // to std::from_chars, which is exact and also far faster than iostreams.
+    bool read_weight(double &value) {
+        skip_blanks();
+        auto start = p;
+        std::uint64_t whole;
+        if(read_uint(whole) && whole < (std::uint64_t(1) << 53) &&
+           (p == end || *p == ' ' || *p == '\t' || *p == '\r' || *p == '\n')) {
+            value = double(whole);
+            return true;
+        }
+        p = start;
+        auto result = std::from_chars(p, end, value);
+        if(result.ec != std::errc()) {
+            return false;
+        }
+        p = result.ptr;
+        return true;
+    }
+};
+
+// Splits text into about count chunks, each ending just after a newline (or
+// at the end of the text), so that no line is split between two chunks.
+inline std::vector<std::string_view> split_text(std::string_view text, size_t count) {
+    auto chunks = std::vector<std::string_view>();
+    size_t start = 0;
+    for(size_t i = 1; i <= count && start < text.size(); ++i) {
+        auto stop = i == count ? text.size() : std::max(start, text.size() * i / count);
+        if(stop < text.size()) {
+            stop = text.find('\n', stop);
+            stop = stop == std::string_view::npos ? text.size() : stop + 1;
+        }
+        if(stop > start) {
+            chunks.push_back(text.substr(start, stop - start));
+            start = stop;
+        }
+    }
+    return chunks;
+}
+
+// Parses every chunk in parallel with parse(chunk_index, cursor, edges),
+// which appends the chunk's edges to its own list, and then concatenates
+// the lists in chunk order (so the edges stay in file order).
+template <class Edge, class F>
+std::vector<Edge> parse_chunks(const std::vector<std::string_view> &chunks, thread_pool &pool, F &&parse) {
+    auto lists = std::vector<std::vector<Edge>>(chunks.size());
+    pool.parallel_for(chunks.size(), [&](unsigned, size_t i) {
+        auto cursor = text_cursor {chunks[i].data(), chunks[i].data() + chunks[i].size()};
+        parse(i, cursor, lists[i]);
+    }, 1);
+    size_t total = 0;
+    for(auto &list : lists) {
+        total += list.size();
+    }
+    auto edges = std::vector<Edge>();
+    edges.reserve(total);
+    for(auto &list : lists) {
+        edges.insert(edges.end(), list.begin(), list.end());
+    }
+    return edges;
+}
+
+inline size_t loader_chunk_count(std::string_view text, thread_pool &pool) {
+    // Several chunks per thread so the work stealing can even things out,
+    // but none so small that the per chunk overhead matters.
+    return std::max<size_t>(1, std::min<size_t>(pool.size() * 4, text.size() / 65536 + 1));
+}
+
+[[noreturn]] inline void malformed(const char *format, const text_cursor &cursor, std::string_view text) {
+    throw std::domain_error(std::string("Malformed ") + format + " line: " + std::string(cursor.line(text.data())));
+}
+
+inline frozen_graph<std::uint64_t> parse_edge_list(std::string_view text, thread_pool &pool) {
+    struct raw_edge {
+        std::uint64_t start;
+        std::uint64_t end;
+        double weight;
+    };
+    auto chunks = split_text(text, loader_chunk_count(text, pool));
+    auto raw = parse_chunks<raw_edge>(chunks, pool, [&](size_t, text_cursor &cursor, std::vector<raw_edge> &edges) {
+        while(!cursor.done()) {
+            if(cursor.at_line_end() || *cursor.p == '#' || *cursor.p == '%') {
+                cursor.skip_line();
+                continue;
+            }
+            raw_edge edge {0, 0, 1.0};
+            if(!cursor.read_uint(edge.start) || !cursor.read_uint(edge.end)) {
+                malformed("edge list", cursor, text);
+            }
+            if(!cursor.at_line_end() && !cursor.read_weight(edge.weight)) {
+                malformed("edge list", cursor, text);
+            }
+            if(!cursor.at_line_end()) {
+                malformed("edge list", cursor, text);
+            }
+            edges.push_back(edge);
+            cursor.skip_line();
+        }
+    });
+
+    // The ids in an edge list needn't be dense, so the distinct ids (sorted)
+    // become the names, and each id's position in that list its node id.
+    // Usually the ids are close to dense already, and then a table indexed
+    // by id does the mapping;  a binary search per endpoint would cost a
+    // cache miss or two each, which is more than parsing the line did.
+    std::uint64_t largest = 0;
+    for(auto &edge : raw) {
+        largest = std::max({largest, edge.start, edge.end});
+    }
+    auto names = std::vector<std::uint64_t>();
+    auto edges = std::vector<frozen_edge>(raw.size());
+    if(largest < raw.size() * 4 + 1024) {
+        auto dense = std::vector<node_id>(largest + 1, 0);
+        for(auto &edge : raw) {
+            dense[edge.start] = 1;
+            dense[edge.end] = 1;
+        }
+        for(std::uint64_t id = 0; id <= largest; ++id) {
+            if(dense[id] != 0) {
+                if(names.size() >= no_node) {
+                    throw std::domain_error("Too many nodes for a frozen graph");
+                }
+                dense[id] = node_id(names.size());
+                names.push_back(id);
+            }
+        }
+        pool.parallel_for(raw.size(), [&](unsigned, size_t i) {
+            edges[i] = {dense[raw[i].start], dense[raw[i].end], raw[i].weight};
+        }, 4096);
+    } else {
+        names.reserve(raw.size() * 2);
+        for(auto &edge : raw) {
+            names.push_back(edge.start);
+            names.push_back(edge.end);
+        }
+        std::sort(names.begin(), names.end());
+        names.erase(std::unique(names.begin(), names.end()), names.end());
+        if(names.size() >= no_node) {
+            throw std::domain_error("Too many nodes for a frozen graph");
+        }
+        pool.parallel_for(raw.size(), [&](unsigned, size_t i) {
+            auto dense = [&](std::uint64_t id) {
+                return node_id(std::lower_bound(names.begin(), names.end(), id) - names.begin());
+            };
+            edges[i] = {dense(raw[i].start), dense(raw[i].end), raw[i].weight};
+        }, 4096);
+    }
+    return frozen_graph<std::uint64_t>(std::move(names), edges);
+}
+
+inline frozen_graph<std::uint64_t> parse_dimacs(std::string_view text, thread_pool &pool) {
+    // The problem line comes before any arcs, so find it first.
+    auto cursor = text_cursor {text.data(), text.data() + text.size()};
+    std::uint64_t nodes = 0, arcs = 0;
+    while(true) {
+        if(cursor.done()) {
+            throw std::domain_error("Malformed DIMACS file: no problem line");
+        }
+        if(cursor.at_line_end() || *cursor.p == 'c') {
+            cursor.skip_line();
+            continue;
+        }
+        if(*cursor.p != 'p') {
+            malformed("DIMACS", cursor, text);
+        }
+        ++cursor.p;
+        cursor.skip_blanks();
+        if(std::string_view(cursor.p, size_t(cursor.end - cursor.p)).substr(0, 2) != "sp") {
+            malformed("DIMACS", cursor, text);
+        }
+        cursor.p += 2;
+        if(!cursor.read_uint(nodes) || !cursor.read_uint(arcs) || !cursor.at_line_end()) {
+            malformed("DIMACS", cursor, text);
+        }
+        cursor.skip_line();
+        break;
+    }
+    if(nodes >= no_node) {
+        throw std::domain_error("Too many nodes for a frozen graph");
+    }
+
+    auto body = text.substr(size_t(cursor.p - text.data()));
+    auto chunks = split_text(body, loader_chunk_count(body, pool));
+    auto edges = parse_chunks<frozen_edge>(chunks, pool, [&](size_t, text_cursor &cursor, std::vector<frozen_edge> &edges) {
+        while(!cursor.done()) {
+            if(cursor.at_line_end() || *cursor.p == 'c') {
+                cursor.skip_line();
+                continue;
+            }
+            if(*cursor.p != 'a') {
+                malformed("DIMACS", cursor, text);
+            }
+            ++cursor.p;
+            std::uint64_t start, end;
+            double weight;
+            if(!cursor.read_uint(start) || !cursor.read_uint(end) || !cursor.read_weight(weight) ||
+               !cursor.at_line_end() || start < 1 || start > nodes || end < 1 || end > nodes) {
+                malformed("DIMACS", cursor, text);
+            }
+            edges.push_back({node_id(start - 1), node_id(end - 1), weight});
+            cursor.skip_line();
+        }
+    });
+    if(edges.size() != arcs) {
+        throw std::domain_error("Malformed DIMACS file: wrong number of arcs");
+    }
+    auto names = std::vector<std::uint64_t>(nodes);
+    for(std::uint64_t i = 0; i < nodes; ++i) {
+        names[i] = i + 1;
+    }
+    return frozen_graph<std::uint64_t>(std::move(names), edges);
+}
+
+inline frozen_graph<std::uint64_t> parse_metis(std::string_view text, thread_pool &pool) {
+    auto cursor = text_cursor {text.data(), text.data() + text.size()};
+    while(!cursor.done() && *cursor.p == '%') {
+        cursor.skip_line();
+    }
+    std::uint64_t nodes = 0, undirected = 0, format = 0, constraints = 0;
+    if(!cursor.read_uint(nodes) || !cursor.read_uint(undirected)) {
+        malformed("METIS", cursor, text);
+    }
+    if(!cursor.at_line_end()) {
+        if(!cursor.read_uint(format)) {
+            malformed("METIS", cursor, text);
+        }
+        if(!cursor.at_line_end() && !cursor.read_uint(constraints)) {
+            malformed("METIS", cursor, text);
+        }
+    }
+    if(!cursor.at_line_end()) {
+        malformed("METIS", cursor, text);
+    }
+    cursor.skip_line();
+    // fmt is three digits:  node sizes, node weights, edge weights.
+    auto has_sizes = format / 100 % 10 == 1;
+    auto has_node_weights = format / 10 % 10 == 1;
+    auto has_edge_weights = format % 10 == 1;
+    if(has_node_weights && constraints == 0) {
+        constraints = 1;
+    }
+    if(nodes >= no_node) {
+        throw std::domain_error("Too many nodes for a frozen graph");
+    }
+
+    // The node a line describes depends on how many lines came before it,
+    // so first count the node lines in each chunk (in parallel), and add
+    // those up to find the node each chunk starts at.  Blank lines count,
+    // since they are nodes with no neighbours;  comment lines don't.
+    auto body = text.substr(size_t(cursor.p - text.data()));
+    auto chunks = split_text(body, loader_chunk_count(body, pool));
+    auto first_node = std::vector<std::uint64_t>(chunks.size() + 1, 0);
+    pool.parallel_for(chunks.size(), [&](unsigned, size_t i) {
+        auto c = text_cursor {chunks[i].data(), chunks[i].data() + chunks[i].size()};
+        std::uint64_t lines = 0;
+        while(!c.done()) {
+            lines += *c.p != '%';
+            c.skip_line();
+        }
+        first_node[i + 1] = lines;
+    }, 1);
+    for(size_t i = 0; i < chunks.size(); ++i) {
+        first_node[i + 1] += first_node[i];
+    }
+
+    auto edges = parse_chunks<frozen_edge>(chunks, pool, [&](size_t chunk, text_cursor &cursor, std::vector<frozen_edge> &edges) {
+        auto node = first_node[chunk];
+        while(!cursor.done()) {
+            if(*cursor.p == '%') {
+                cursor.skip_line();
+                continue;
+            }
+            if(node >= nodes) {
+                // Trailing blank lines are fine, anything else isn't.
+                if(!cursor.at_line_end()) {
+                    malformed("METIS", cursor, text);
+                }
+                cursor.skip_line();
+                continue;
+            }
+            std::uint64_t ignored;
+            for(std::uint64_t k = 0; k < has_sizes + constraints; ++k) {
+                if(!cursor.read_uint(ignored)) {
+                    malformed("METIS", cursor, text);
+                }
+            }
+            while(!cursor.at_line_end()) {
+                std::uint64_t neighbour;
+                double weight = 1.0;
+                if(!cursor.read_uint(neighbour) || neighbour < 1 || neighbour > nodes ||
+                   (has_edge_weights && !cursor.read_weight(weight))) {
+                    malformed("METIS", cursor, text);
+                }
+                edges.push_back({node_id(node), node_id(neighbour - 1), weight});
+            }
+            cursor.skip_line();
+            node++;
+        }
+    });
+    if(first_node.back() < nodes) {
+        throw std::domain_error("Malformed METIS file: too few node lines");
+    }
+    if(edges.size() != undirected * 2) {
+        throw std::domain_error("Malformed METIS file: wrong number of edges");
+    }
+    auto names = std::vector<std::uint64_t>(nodes);
+    for(std::uint64_t i = 0; i < nodes; ++i) {
+        names[i] = i + 1;
+    }
+    return frozen_graph<std::uint64_t>(std::move(names), edges);
+}
+
+inline frozen_graph<std::uint64_t> load_edge_list(const std::string &path, thread_pool &pool) {
+    auto file = mapped_file(path);
+    return parse_edge_list(file.text(), pool);
+}
+
+inline frozen_graph<std::uint64_t> load_dimacs(const std::string &path, thread_pool &pool) {
+    auto file = mapped_file(path);
+    return parse_dimacs(file.text(), pool);
+}
+
+inline frozen_graph<std::uint64_t> load_metis(const std::string &path, thread_pool &pool) {
+    auto file = mapped_file(path);
+    return parse_metis(file.text(), pool);
+}
+
+void testGraphLoaders();
+
+#endif //GRAPH_LOADERS_H
@@ -0,0 +1,84 @@
+#include "graph_reordering.hpp"
+
+#include <cassert>
+#include <iostream>
+#include <random>
+#include <string>
+
+#include "dijkstra_workspace.hpp"
+
+// Builds a grid with its nodes shuffled, and checks that every ordering is
+// a permutation, that the reordered graph has exactly the same (named)
+// edges and shortest paths, and that the orderings really do bring
+// neighbours closer together than the shuffle had them.
+
+static frozen_graph<std::string> shuffled_grid(int side) {
+    auto rng = std::default_random_engine {};
+    auto shuffle = std::vector<node_id>(side * side);
+    std::iota(shuffle.begin(), shuffle.end(), 0);
+    std::shuffle(shuffle.begin(), shuffle.end(), rng);
+    auto names = std::vector<std::string>(side * side);
+    auto edges = std::vector<frozen_edge>();
+    auto weight = std::uniform_real_distribution<double>(1.0, 2.0);
+    for(auto row = 0; row < side; ++row) {
+        for(auto column = 0; column < side; ++column) {
+            auto u = shuffle[row * side + column];
+            names[u] = std::to_string(row) + "," + std::to_string(column);
+            if(column + 1 < side) {
+                edges.push_back({u, shuffle[row * side + column + 1], weight(rng)});
+                edges.push_back({shuffle[row * side + column + 1], u, weight(rng)});
+            }
+            if(row + 1 < side) {
+                edges.push_back({u, shuffle[(row + 1) * side + column], weight(rng)});
+            }
+        }
+    }
+    return frozen_graph<std::string>(std::move(names), edges);
+}
+
+static void check(const frozen_graph<std::string> &g, const node_permutation &permutation) {
+    assert(permutation.new_to_old.size() == g.node_count());
+    for(node_id i = 0; i < g.node_count(); ++i) {
+        assert(permutation.old_to_new[permutation.new_to_old[i]] == i);
+    }
+    auto reordered = reorder(g, permutation);
+    assert(reordered.node_count() == g.node_count());
+    assert(reordered.edge_count() == g.edge_count());
+    for(node_id u = 0; u < g.node_count(); ++u) {
+        auto v = permutation.old_to_new[u];
+        assert(reordered.name(v) == g.name(u));
+        auto expected = std::vector<std::pair<std::string, double>>();
+        auto actual = std::vector<std::pair<std::string, double>>();
+        g.for_each_out_edge(u, [&](node_id next, double w) { expected.emplace_back(g.name(next), w); });
+        reordered.for_each_out_edge(v, [&](node_id next, double w) { actual.emplace_back(reordered.name(next), w); });
+        assert(expected == actual);
+    }
+
+    auto before = dijkstra_workspace();
+    auto after = dijkstra_workspace();
+    before.run(g, g.id("0,0"));
+    after.run(reordered, reordered.id("0,0"));
+    for(node_id u = 0; u < g.node_count(); ++u) {
+        assert(before.distance(u) == after.distance(reordered.id(g.name(u))));
+    }
+
+    assert(id_spread(reordered).second * 4 < id_spread(g).second);
+}
+
+void testGraphReordering() {
+    std::cerr << "Initializing graph reordering tests" << std::endl;
+    auto g = shuffled_grid(40);
+    check(g, bfs_order(g));
+    check(g, rcm_order(g));
+    check(g, gorder(g));
+    // On a grid RCM gets the bandwidth down to about the width of the grid.
+    assert(id_spread(reorder(g, rcm_order(g))).first <= 2 * 40);
+
+    auto rejected = false;
+    try {
+        node_permutation({0, 0});
+    } catch(std::domain_error &) {
+        rejected = true;
+    }
+    assert(rejected);
+}
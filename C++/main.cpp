@@ -1,10 +1,52 @@
 #include <iostream>
 
 #include "graph.hpp"
+#include "frozen_graph.hpp"
+#include "delta_stepping.hpp"
+#include "query_executor.hpp"
+#include "versioned_graph.hpp"
+#include "concurrent_graph.hpp"
+#include "traversal_generator.hpp"
+#include "binary_graph.hpp"
+#include "graph_loaders.hpp"
+#include "compressed_graph.hpp"
+#include "graph_reordering.hpp"
+#include "shortest_path_tree.hpp"
+#include "dynamic_sssp.hpp"
+#include "graph_generators.hpp"
+#include "traversal_stats.hpp"
+#include "perf_counters.hpp"
+#include "counting_allocator.hpp"
+#include "bfs.hpp"
+#include "dfs.hpp"
+#include "components.hpp"
+#include "reachability.hpp"
+#include "apsp.hpp"
 
 
 int main(int argc, char **argv) {
     testGraph();
+    testFrozenGraph();
+    testDeltaStepping();
+    testQueryExecutor();
+    testVersionedGraph();
+    testConcurrentGraph();
+    testTraversalGenerator();
+    testBinaryGraph();
+    testGraphLoaders();
+    testCompressedGraph();
+    testGraphReordering();
+    testShortestPathTree();
+    testDynamicSssp();
+    testGraphGenerators();
+    testTraversalStats();
+    testPerfCounters();
+    testCountingAllocator();
+    testBfs();
+    testDfs();
+    testComponents();
+    testReachability();
+    testApsp();
     std::cout << "Hello, World!" << std::endl;
     for(auto x = 0; x < argc; ++x ){
         std::cout << x << ":" << argv[x] << std::endl;
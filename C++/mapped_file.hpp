@@ -0,0 +1,75 @@
+#ifndef MAPPED_FILE_H
+#define MAPPED_FILE_H
+
+#include <cerrno>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <utility>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// A whole file mapped read-only into memory, unmapped again when this goes
+// away.  Throws std::system_error if the file can't be opened or mapped.
+// An empty file maps to an empty view (mmap refuses zero length mappings).
+class mapped_file {
+private:
+    void *mapping = nullptr;
+    size_t mapping_size = 0;
+
+public:
+    explicit mapped_file(const std::string &path) {
+        auto fd = open(path.c_str(), O_RDONLY);
+        if(fd < 0) {
+            throw std::system_error(errno, std::generic_category(), "Unable to open " + path);
+        }
+        struct stat info {};
+        if(fstat(fd, &info) != 0) {
+            auto error = errno;
+            close(fd);
+            throw std::system_error(error, std::generic_category(), "Unable to stat " + path);
+        }
+        mapping_size = size_t(info.st_size);
+        if(mapping_size == 0) {
+            close(fd);
+            return;
+        }
+        mapping = mmap(nullptr, mapping_size, PROT_READ, MAP_SHARED, fd, 0);
+        auto error = errno;
+        close(fd);
+        if(mapping == MAP_FAILED) {
+            mapping = nullptr;
+            throw std::system_error(error, std::generic_category(), "Unable to map " + path);
+        }
+    }
+
+    mapped_file(mapped_file &&other) noexcept :
+    mapping(std::exchange(other.mapping, nullptr)), mapping_size(std::exchange(other.mapping_size, 0)) {
+    }
+
+    mapped_file(const mapped_file &) = delete;
+    mapped_file &operator=(const mapped_file &) = delete;
+
+    ~mapped_file() {
+        if(mapping != nullptr) {
+            munmap(mapping, mapping_size);
+        }
+    }
+
+    const char *data() const {
+        return static_cast<const char *>(mapping);
+    }
+
+    size_t size() const {
+        return mapping_size;
+    }
+
+    std::string_view text() const {
+        return {data(), size()};
+    }
+};
+
+#endif //MAPPED_FILE_H
@@ -0,0 +1,41 @@
+#include "perf_counters.hpp"
+
+#include <cassert>
+#include <iostream>
+#include <vector>
+
+// Whether the counters work depends on the machine (many VMs and
+// containers have none), so all this can check is that they read as
+// unavailable cleanly, and that when they are there they count something
+// sensible:  more work, more instructions.
+
+static std::uint64_t busy_work(size_t n) {
+    auto values = std::vector<std::uint64_t>(n);
+    std::uint64_t total = 0;
+    for(size_t i = 0; i < n; ++i) {
+        values[i] = i * 2654435761u;
+        total += values[(i * 7919) % (i + 1)];
+    }
+    return total;
+}
+
+void testPerfCounters() {
+    std::cerr << "Initializing perf counter tests" << std::endl;
+    auto counters = perf_counters();
+    counters.start();
+    volatile auto small = busy_work(1000);
+    auto little = counters.stop();
+    counters.start();
+    volatile auto large = busy_work(1000000);
+    auto lots = counters.stop();
+    (void) small;
+    (void) large;
+    for(size_t c = 0; c < perf_counters::counter_count; ++c) {
+        auto which = perf_counters::counter(c);
+        assert(little.available(which) == lots.available(which));
+        assert(little.available(which) || (little[which] == 0 && lots[which] == 0));
+    }
+    if(lots.available(perf_counters::instructions)) {
+        assert(lots[perf_counters::instructions] > little[perf_counters::instructions]);
+    }
+}
@@ -0,0 +1,116 @@
+#include "query_executor.hpp"
+
+#include <cassert>
+#include <random>
+
+#include "graph_generators.hpp"
+
+// Runs a batch of random queries through the executor and checks every
+// answer against a plain dijkstra_traversal from the same source:  the
+// distances have to match exactly, the answers have to come back in the
+// order the queries went in, and each path has to be a real path in the
+// graph with the right total length.
+
+void testQueryExecutor() {
+    std::cerr << "Initializing query executor tests" << std::endl;
+    const int count = 300;
+    auto generated = erdos_renyi_graph(count, 3);
+    auto g = build_graph<int>(generated);
+    auto weights = std::map<std::pair<int, int>, double>();
+    for(auto &e : generated.edges) {
+        weights[{e.start, e.end}] = e.weight;
+    }
+
+    auto expected = std::map<int, std::unordered_map<int, double>>();
+    for(auto source = 0; source < 20; ++source) {
+        for(auto step : dijkstra_traversal<int>(g, source)) {
+            expected[source][step->current->name] = step->distance;
+        }
+    }
+
+    auto rng = std::default_random_engine {};
+    auto pick = std::uniform_int_distribution<int>(0, count - 1);
+    auto queries = std::vector<path_query<int>>();
+    for(auto i = 0; i < 2000; ++i) {
+        auto source = i % 20;
+        auto target = pick(rng);
+        queries.push_back({source, target, i % 3 != 0});
+    }
+    // A distance cap that cuts off some of the queries.
+    queries.push_back({0, 0, true, 0});
+    queries.push_back({1, pick(rng), true, 20.0});
+
+    auto executor = query_executor<int>(*g, 4);
+    for(auto repeat = 0; repeat < 2; ++repeat) {
+        // The second time round, with the reachability index as well.
+        if(repeat == 1) {
+            executor.index_reachability();
+        }
+        auto answers = executor.run(queries);
+        assert(answers.size() == queries.size());
+        for(size_t i = 0; i < queries.size(); ++i) {
+            auto &query = queries[i];
+            auto &answer = answers[i];
+            auto &reachable = expected[query.source];
+            auto exact = reachable.contains(query.target) ? reachable[query.target] : HUGE_VAL;
+            if(exact > query.max_distance) {
+                assert(answer.distance == HUGE_VAL);
+                assert(answer.path.empty());
+                continue;
+            }
+            assert(answer.distance == exact);
+            if(!query.with_path || exact == HUGE_VAL) {
+                assert(answer.path.empty());
+                continue;
+            }
+            assert(answer.path.front() == query.source);
+            assert(answer.path.back() == query.target);
+            double total = 0;
+            for(size_t k = 1; k < answer.path.size(); ++k) {
+                total += weights.at({answer.path[k - 1], answer.path[k]});
+            }
+            assert(total == exact);
+        }
+    }
+
+    // Two separate rings:  queries across them are turned away by the
+    // component check, and within them still answered.
+    auto rings = graph<int>();
+    for(auto i = 0; i < 20; ++i) {
+        rings.create_node(i);
+    }
+    for(auto i = 0; i < 10; ++i) {
+        rings.create_link(i, (i + 1) % 10, 1);
+        rings.create_link(10 + i, 10 + (i + 1) % 10, 1);
+    }
+    auto split = query_executor<int>(rings, 2);
+    assert(split.components().count == 2);
+    auto across = split.run({{0, 15}, {3, 7}, {12, 11}});
+    assert(across[0].distance == HUGE_VAL && across[0].path.empty());
+    assert(across[1].distance == 4 && across[1].path.size() == 5);
+    assert(across[2].distance == 9);
+    // Against the direction of a one way link:  same weak component, so
+    // without the reachability index it takes a search to turn it away,
+    // and with it the labels do.
+    rings.create_link(5, 12, 1);
+    auto one_way = query_executor<int>(rings, 2);
+    assert(one_way.components().count == 1);
+    assert(!one_way.reachability());
+    auto against = one_way.run({{12, 5}, {5, 13}});
+    assert(against[0].distance == HUGE_VAL);
+    assert(against[1].distance == 2);
+    one_way.index_reachability();
+    assert(!one_way.reachability()->might_reach(one_way.frozen().id(12), one_way.frozen().id(5)));
+    against = one_way.run({{12, 5}, {5, 13}, {5, 13, true, 1.5}});
+    assert(against[0].distance == HUGE_VAL);
+    assert(against[1].distance == 2 && against[1].path.size() == 3);
+    assert(against[2].distance == HUGE_VAL);
+
+    auto failed = false;
+    try {
+        executor.run({{0, count + 5}});
+    } catch(std::logic_error &) {
+        failed = true;
+    }
+    assert(failed);
+}
@@ -0,0 +1,138 @@
+#ifndef QUERY_EXECUTOR_H
+#define QUERY_EXECUTOR_H
+
+#include <memory>
+#include <optional>
+#include <vector>
+
+#include "components.hpp"
+#include "dijkstra_workspace.hpp"
+#include "frozen_graph.hpp"
+#include "reachability.hpp"
+#include "thread_pool.hpp"
+
+// Answers batches of independent point to point shortest path queries
+// against one read-only graph, spread across a thread pool.
+//
+// The graph is frozen once up front and shared by every thread (nothing
+// writes to it, so no locking is needed), and each pool worker owns its own
+// dijkstra_workspace, so after the first few queries a worker answers
+// queries without allocating anything but the returned paths.
+//
+// The pool's work stealing matters here since query costs vary wildly:  a
+// query between two nearby nodes settles a handful of nodes, while one
+// between distant nodes can settle most of the graph.
+//
+// Results come back in the same order as the queries were submitted, since
+// each query writes only to its own slot of the result vector.
+//
+// The weakly connected components are worked out once up front (on the
+// pool), so a query between two different components is answered as
+// unreachable straight away, rather than by a search that settles the
+// whole of the source's component before giving up.
+//
+// index_reachability() adds a reachability_index, to catch most of the
+// rest of the unreachable queries, the ones within a component but against
+// the direction of its edges.  It's opt in, since building it is a serial
+// pass over the whole graph, only worth paying for when many queries are
+// unreachable that way.  Queries only ask its labels (might_reach), never
+// its fallback search:  that can cost as much as a search of the whole
+// condensation, which a query with a small max_distance would never do,
+// so a "maybe" is left to the Dijkstra search, which the limit bounds.
+
+template <class T>
+struct path_query {
+    T source;
+    T target;
+    // Whether to return the nodes along the path, or just the distance.
+    bool with_path = true;
+    // Give up on targets further away than this (reported as unreachable).
+    double max_distance = HUGE_VAL;
+};
+
+template <class T>
+struct path_answer {
+    // +infinity if the target can't be reached (within max_distance).
+    double distance = HUGE_VAL;
+    // From source to target inclusive, if requested and reachable.
+    std::vector<T> path {};
+};
+
+template <class T>
+class query_executor {
+private:
+    std::shared_ptr<const frozen_graph<T>> working_graph;
+    thread_pool pool;
+    std::vector<dijkstra_workspace> workspaces;
+    std::vector<std::vector<node_id>> paths;
+    component_labels weak_components;
+    std::optional<reachability_index> reachable;
+
+public:
+    explicit query_executor(std::shared_ptr<const frozen_graph<T>> g,
+                            unsigned threads = std::thread::hardware_concurrency()) :
+    working_graph(g), pool(threads), workspaces(pool.size()), paths(pool.size()) {
+        weak_components = weakly_connected_components(*working_graph, pool);
+    }
+
+    explicit query_executor(const graph<T> &g,
+                            unsigned threads = std::thread::hardware_concurrency()) :
+    query_executor(std::make_shared<const frozen_graph<T>>(g), threads) {
+    }
+
+    const frozen_graph<T> &frozen() const {
+        return *working_graph;
+    }
+
+    const component_labels &components() const {
+        return weak_components;
+    }
+
+    // Builds the reachability_index run() checks queries against (see
+    // reachability.hpp for label_count).  Not safe to call during run().
+    void index_reachability(unsigned label_count = 3) {
+        reachable.emplace(*working_graph, label_count);
+    }
+
+    // Empty until index_reachability() is called.
+    const std::optional<reachability_index> &reachability() const {
+        return reachable;
+    }
+
+    // Runs every query in the batch and returns the answers in order.  An
+    // unknown node name throws std::logic_error, as dijkstra_traversal does.
+    std::vector<path_answer<T>> run(const std::vector<path_query<T>> &queries) {
+        auto answers = std::vector<path_answer<T>>(queries.size());
+        auto &g = *working_graph;
+        pool.parallel_for(queries.size(), [&](unsigned worker, size_t i) {
+            auto &query = queries[i];
+            auto &answer = answers[i];
+            auto &workspace = workspaces[worker];
+            auto source = g.id(query.source);
+            auto target = g.id(query.target);
+            if(!weak_components.connected(source, target) ||
+               (reachable && !reachable->might_reach(source, target))) {
+                return;
+            }
+            workspace.run(g, source, target, query.max_distance);
+            auto distance = workspace.distance(target);
+            if(distance > query.max_distance) {
+                return;
+            }
+            answer.distance = distance;
+            if(query.with_path) {
+                auto &path = paths[worker];
+                workspace.path_to(target, path);
+                answer.path.reserve(path.size());
+                for(auto node : path) {
+                    answer.path.push_back(g.name(node));
+                }
+            }
+        }, 1);
+        return answers;
+    }
+};
+
+void testQueryExecutor();
+
+#endif //QUERY_EXECUTOR_H
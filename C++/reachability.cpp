@@ -0,0 +1,87 @@
+#include "reachability.hpp"
+
+#include <cassert>
+#include <iostream>
+
+#include "graph_generators.hpp"
+#include "reference_search.hpp"
+
+// Checks every pair of nodes against a plain search from each node, on
+// graphs with a few big strong components and many small ones (sparse
+// random graphs and R-MAT), and on DAGs, where every component is a single
+// node and the labels do all the work.
+
+// Returns how many of the unreachable pairs the labels alone turned away.
+static double check(const frozen_graph<std::uint64_t> &g, const reachability_index &index) {
+    auto search = reachability_search();
+    size_t unreachable = 0;
+    size_t searched = 0;
+    for(node_id a = 0; a < g.node_count(); ++a) {
+        auto hops = reference_hops(g, a);
+        for(node_id b = 0; b < g.node_count(); ++b) {
+            auto expected = hops[b] != no_hops;
+            auto before = search.search_count();
+            assert(index.reaches(a, b, search) == expected);
+            // The labels alone may say maybe, but never no to a real path.
+            assert(index.might_reach(a, b) || !expected);
+            if(!expected) {
+                unreachable++;
+                searched += search.search_count() - before;
+            }
+        }
+    }
+    return unreachable == 0 ? 1 : 1 - double(searched) / double(unreachable);
+}
+
+void testReachability() {
+    std::cerr << "Initializing reachability tests" << std::endl;
+    for(auto seed = 1u; seed <= 3; ++seed) {
+        auto sparse = freeze(erdos_renyi_graph(400, 1.5, seed));
+        check(sparse, reachability_index(sparse));
+        // A single label still gives exact answers, just more searches.
+        check(sparse, reachability_index(sparse, 1, seed));
+    }
+    auto rmat = freeze(rmat_graph(9, 2));
+    auto index = reachability_index(rmat);
+    assert(index.components().count > 1);
+    check(rmat, index);
+
+    // Pointing every edge from the lower numbered node makes a DAG.
+    auto generated = erdos_renyi_graph(500, 3);
+    for(auto &e : generated.edges) {
+        if(e.start > e.end) {
+            std::swap(e.start, e.end);
+        }
+    }
+    remove_duplicate_edges(generated.edges);
+    auto dag = freeze(generated);
+    auto dag_index = reachability_index(dag, 4);
+    assert(dag_index.components().count == dag.node_count());
+    assert(dag_index.dag_edge_count() == dag.edge_count());
+    auto turned_away = check(dag, dag_index);
+    // The labels should settle the great majority of unreachable pairs.
+    assert(turned_away > 0.8);
+
+    auto grid = freeze(grid_graph(20, 20));
+    auto grid_index = reachability_index(grid);
+    assert(grid_index.components().count == 1 && grid_index.dag_edge_count() == 0);
+    assert(grid_index.reaches(0, 399) && grid_index.reaches(399, 0));
+
+    auto empty = freeze(generated_graph());
+    assert(reachability_index(empty).components().count == 0);
+
+    auto rejected = 0;
+    for(auto [a, b] : {std::pair<node_id, node_id> {0, 400}, {400, 0}}) {
+        try {
+            grid_index.reaches(a, b);
+        } catch(std::logic_error &) {
+            rejected++;
+        }
+        try {
+            grid_index.might_reach(a, b);
+        } catch(std::logic_error &) {
+            rejected++;
+        }
+    }
+    assert(rejected == 4);
+}
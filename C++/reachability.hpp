@@ -0,0 +1,262 @@
+#ifndef REACHABILITY_H
+#define REACHABILITY_H
+
+#include <algorithm>
+#include <cstdint>
+#include <numeric>
+#include <random>
+#include <stdexcept>
+#include <vector>
+
+#include "components.hpp"
+
+// An index answering "can a reach b" without a traversal (most of the
+// time), for turning away unreachable point to point queries before
+// routing.
+//
+// First the graph is shrunk to its condensation:  each strongly connected
+// component becomes one node, with an edge between two components whenever
+// the graph has an edge between them.  That's a DAG, and a reaches b
+// exactly when a's component reaches b's in it.  The components are
+// numbered in reverse topological order (see components.hpp), so a can
+// only reach b if a's component number is at least b's:  a free first
+// check that already rules out about half of random pairs.
+//
+// Then each component gets GRAIL labels (Yildirim, Chaoji and Zaki,
+// "GRAIL: Scalable Reachability Index for Large Graphs", VLDB 2010).  A
+// depth first search over the DAG numbers the components in post-order,
+// and labels each one with the interval from the lowest number anywhere
+// below it up to its own number.  Everything reachable from c is below c
+// in the search, so if c reaches d then d's interval lies inside c's.  The
+// reverse isn't true (the interval can cover components that just happened
+// to be numbered in between), so a few searches are done, each visiting
+// the children in a different random order:  b's interval falling outside
+// a's in any one of them proves a can't reach b.
+//
+// When every label says "maybe", a depth first search over the DAG from
+// a's component settles it, but a pruned one:  it never goes into a
+// component whose labels already rule out b.  So reaches() is always exact,
+// and usually only looks at the labels.  That search can still cover much
+// of the DAG, though, so a caller about to run a bounded search anyway
+// (a query with a distance limit, say) should ask might_reach() instead,
+// which only ever looks at the labels and leaves "maybe" to it.
+
+class reachability_index;
+
+// The scratch space for the searches reaches() falls back on, kept between
+// queries.  Not thread safe;  give each thread its own.
+class reachability_search {
+    friend reachability_index;
+
+private:
+    std::vector<node_id> stack;
+    std::vector<std::uint32_t> stamps;
+    std::uint32_t current_stamp = 0;
+    size_t searches = 0;
+
+public:
+    // How many queries couldn't be answered from the labels alone.
+    size_t search_count() const {
+        return searches;
+    }
+};
+
+class reachability_index {
+private:
+    struct interval {
+        node_id low;
+        node_id high;
+    };
+
+    component_labels strong;
+    // The condensation, with each component's out edges (to the other
+    // components it has an edge to, once each) at
+    // dag_targets[dag_offsets[c]..dag_offsets[c + 1]).
+    std::vector<size_t> dag_offsets;
+    std::vector<node_id> dag_targets;
+    unsigned label_count;
+    // Component c's labels are labels[c * label_count..(c + 1) * label_count).
+    std::vector<interval> labels;
+
+    void check(node_id node) const {
+        if(node >= strong.component.size()) {
+            throw std::logic_error("Unable to find the node");
+        }
+    }
+
+    bool labels_allow(node_id from, node_id to) const {
+        if(from < to) {
+            return false;
+        }
+        auto a = &labels[size_t(from) * label_count];
+        auto b = &labels[size_t(to) * label_count];
+        for(unsigned i = 0; i < label_count; ++i) {
+            if(b[i].low < a[i].low || b[i].high > a[i].high) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    void label(unsigned which, std::mt19937_64 &rng) {
+        auto count = strong.count;
+        auto order = std::vector<node_id>(count);
+        std::iota(order.begin(), order.end(), 0);
+        std::shuffle(order.begin(), order.end(), rng);
+        // Each search starts every component's children at a random point
+        // in its list, and goes round from there.
+        auto start = std::vector<size_t>(count);
+        auto visited = std::vector<bool>(count, false);
+        struct frame {
+            node_id component;
+            size_t done;
+        };
+        auto path = std::vector<frame>();
+        node_id next_number = 0;
+        for(auto root : order) {
+            if(visited[root]) {
+                continue;
+            }
+            auto enter = [&](node_id c) {
+                visited[c] = true;
+                auto degree = dag_offsets[c + 1] - dag_offsets[c];
+                start[c] = degree == 0 ? 0 : rng() % degree;
+                labels[size_t(c) * label_count + which].low = no_node;
+                path.push_back({c, 0});
+            };
+            enter(root);
+            while(!path.empty()) {
+                auto &top = path.back();
+                auto c = top.component;
+                auto first = dag_offsets[c];
+                auto degree = dag_offsets[c + 1] - first;
+                auto &own = labels[size_t(c) * label_count + which];
+                if(top.done < degree) {
+                    auto child = dag_targets[first + (start[c] + top.done++) % degree];
+                    if(!visited[child]) {
+                        enter(child);
+                    } else {
+                        own.low = std::min(own.low, labels[size_t(child) * label_count + which].low);
+                    }
+                    continue;
+                }
+                own.high = next_number++;
+                own.low = std::min(own.low, own.high);
+                path.pop_back();
+                if(!path.empty()) {
+                    auto &parent = labels[size_t(path.back().component) * label_count + which];
+                    parent.low = std::min(parent.low, own.low);
+                }
+            }
+        }
+    }
+
+public:
+    // label_count is how many random searches to label with:  more makes
+    // the fallback search rarer, at label_count * 8 bytes per component.
+    template <class Graph>
+    explicit reachability_index(const Graph &g, unsigned label_countIn = 3, std::uint64_t seed = 1) :
+    strong(strongly_connected_components(g)), label_count(std::max(1u, label_countIn)) {
+        auto count = strong.count;
+        auto edges = std::vector<std::pair<node_id, node_id>>();
+        for(node_id u = 0; u < g.node_count(); ++u) {
+            auto from = strong.component[u];
+            g.for_each_out_edge(u, [&](node_id v, double) {
+                auto to = strong.component[v];
+                if(from != to) {
+                    edges.push_back({from, to});
+                }
+            });
+        }
+        std::sort(edges.begin(), edges.end());
+        edges.erase(std::unique(edges.begin(), edges.end()), edges.end());
+        dag_offsets.assign(size_t(count) + 1, 0);
+        dag_targets.reserve(edges.size());
+        for(auto [from, to] : edges) {
+            dag_offsets[from + 1]++;
+            dag_targets.push_back(to);
+        }
+        std::partial_sum(dag_offsets.begin(), dag_offsets.end(), dag_offsets.begin());
+
+        labels.resize(size_t(count) * label_count);
+        auto rng = std::mt19937_64(seed);
+        for(unsigned which = 0; which < label_count; ++which) {
+            label(which, rng);
+        }
+    }
+
+    // The strongly connected components the index is built on.
+    const component_labels &components() const {
+        return strong;
+    }
+
+    size_t dag_edge_count() const {
+        return dag_targets.size();
+    }
+
+    // false if the labels prove there is no path from a to b, and true if
+    // there may be one.  Never searches, so it takes O(label_count).
+    bool might_reach(node_id a, node_id b) const {
+        check(a);
+        check(b);
+        auto from = strong.component[a];
+        auto to = strong.component[b];
+        return from == to || labels_allow(from, to);
+    }
+
+    // Whether there is a path from a to b (a always reaches itself).
+    bool reaches(node_id a, node_id b, reachability_search &search) const {
+        check(a);
+        check(b);
+        auto from = strong.component[a];
+        auto to = strong.component[b];
+        if(from == to) {
+            return true;
+        }
+        if(!labels_allow(from, to)) {
+            return false;
+        }
+        search.searches++;
+        if(search.stamps.size() != strong.count) {
+            search.stamps.assign(strong.count, 0);
+            search.current_stamp = 0;
+        }
+        if(++search.current_stamp == 0) {
+            std::fill(search.stamps.begin(), search.stamps.end(), 0);
+            search.current_stamp = 1;
+        }
+        auto &stack = search.stack;
+        stack.clear();
+        stack.push_back(from);
+        search.stamps[from] = search.current_stamp;
+        while(!stack.empty()) {
+            auto c = stack.back();
+            stack.pop_back();
+            for(auto k = dag_offsets[c]; k < dag_offsets[c + 1]; ++k) {
+                auto child = dag_targets[k];
+                if(child == to) {
+                    return true;
+                }
+                if(search.stamps[child] != search.current_stamp && labels_allow(child, to)) {
+                    search.stamps[child] = search.current_stamp;
+                    stack.push_back(child);
+                }
+            }
+        }
+        return false;
+    }
+
+    bool reaches(node_id a, node_id b) const {
+        auto search = reachability_search();
+        return reaches(a, b, search);
+    }
+
+    size_t memory_usage() const {
+        return strong.component.capacity() * sizeof(node_id) + dag_offsets.capacity() * sizeof(size_t) +
+               dag_targets.capacity() * sizeof(node_id) + labels.capacity() * sizeof(interval);
+    }
+};
+
+void testReachability();
+
+#endif //REACHABILITY_H
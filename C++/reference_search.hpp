@@ -0,0 +1,37 @@
+#ifndef REFERENCE_SEARCH_H
+#define REFERENCE_SEARCH_H
+
+#include <cstdint>
+#include <deque>
+#include <vector>
+
+#include "bfs.hpp"
+
+// The simplest possible breadth first search, for the tests to check the
+// real engines (BFS, components, reachability) against:  hop counts from
+// source along out edges, or along edges either way if undirected, and
+// no_hops for the nodes it can't reach.
+
+template <class Graph>
+std::vector<std::uint32_t> reference_hops(const Graph &g, node_id source, bool undirected = false) {
+    auto hops = std::vector<std::uint32_t>(g.node_count(), no_hops);
+    auto queue = std::deque<node_id> {source};
+    hops[source] = 0;
+    while(!queue.empty()) {
+        auto u = queue.front();
+        queue.pop_front();
+        auto visit = [&](node_id v, double) {
+            if(hops[v] == no_hops) {
+                hops[v] = hops[u] + 1;
+                queue.push_back(v);
+            }
+        };
+        g.for_each_out_edge(u, visit);
+        if(undirected) {
+            g.for_each_in_edge(u, visit);
+        }
+    }
+    return hops;
+}
+
+#endif //REFERENCE_SEARCH_H
@@ -0,0 +1,117 @@
+#include "shortest_path_tree.hpp"
+
+#include <cassert>
+#include <iostream>
+#include <set>
+
+#include "graph_generators.hpp"
+
+// Builds trees from random graphs two ways (Dijkstra and delta stepping)
+// and checks them against dijkstra_traversal:  the distances, the paths
+// (walked through the previous pointers), and the subtrees, checked
+// against walking up the parents by hand.
+
+static bool brute_force_below(const shortest_path_tree<int> &tree, node_id ancestor, node_id node) {
+    if(!tree.reached(node)) {
+        return false;
+    }
+    for(auto u = node; u != no_node; u = tree.parent(u)) {
+        if(u == ancestor) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static void check(const shortest_path_tree<int> &tree, const std::shared_ptr<graph<int>> &g) {
+    auto &frozen = tree.frozen();
+    auto expected = std::unordered_map<int, std::vector<int>>();
+    auto distances = std::unordered_map<int, double>();
+    for(auto step : dijkstra_traversal<int>(g, frozen.name(tree.source()))) {
+        auto path = std::vector<int> {step->current->name};
+        if(step->previous != nullptr) {
+            auto &before = expected[step->previous->name];
+            path.insert(path.begin(), before.begin(), before.end());
+        }
+        expected[step->current->name] = path;
+        distances[step->current->name] = step->distance;
+    }
+
+    auto path = std::vector<node_id>();
+    node_id buffer[4];
+    for(node_id u = 0; u < frozen.node_count(); ++u) {
+        auto name = frozen.name(u);
+        assert(tree.reached(u) == expected.contains(name));
+        if(!tree.reached(u)) {
+            assert(tree.distance(u) == HUGE_VAL);
+            assert(tree.parent(u) == no_node);
+            assert(tree.subtree(u).empty());
+            assert(tree.path_to(u, buffer) == 0);
+            continue;
+        }
+        assert(tree.distance(u) == distances[name]);
+        assert(tree.distance(name) == distances[name]);
+        tree.path_to(u, path);
+        assert(path.size() == tree.depth(u) + 1);
+        assert(path.front() == tree.source() && path.back() == u);
+        // Ties between equally short paths can go either way, so check the
+        // path is a real one of the right length rather than the same one.
+        double length = 0;
+        for(size_t k = 1; k < path.size(); ++k) {
+            auto found = false;
+            frozen.for_each_out_edge(path[k - 1], [&](node_id next, double w) {
+                if(next == path[k] && !found) {
+                    length += w;
+                    found = true;
+                }
+            });
+            assert(found);
+        }
+        assert(length == tree.distance(u));
+        auto needed = tree.path_to(u, buffer);
+        assert(needed == path.size());
+        if(needed <= 4) {
+            assert(std::equal(path.begin(), path.end(), buffer));
+        }
+    }
+
+    // Subtrees, for a sample of roots.
+    for(node_id root = 0; root < frozen.node_count(); root += 7) {
+        auto below = tree.subtree(root);
+        auto members = std::set<node_id>(below.begin(), below.end());
+        assert(members.size() == below.size());
+        if(tree.reached(root)) {
+            assert(below.front() == root);
+        }
+        for(node_id u = 0; u < frozen.node_count(); ++u) {
+            auto inside = brute_force_below(tree, root, u);
+            assert(tree.in_subtree(root, u) == inside);
+            assert(members.contains(u) == inside);
+        }
+    }
+    assert(tree.subtree(tree.source()).size() == expected.size());
+}
+
+void testShortestPathTree() {
+    std::cerr << "Initializing shortest path tree tests" << std::endl;
+    auto pool = thread_pool(4);
+    for(auto k = 0; k < 5; ++k) {
+        // Whole number weights, so there are plenty of ties.
+        auto generated = erdos_renyi_graph(300, 2, k);
+        use_whole_weights(generated, 5);
+        auto g = build_graph<int>(generated);
+        auto frozen = std::make_shared<const frozen_graph<int>>(*g);
+        check(build_shortest_path_tree(frozen, 0), g);
+        auto source = frozen->id(k);
+        check(shortest_path_tree<int>(frozen, source, delta_stepping(*frozen, source, pool)), g);
+    }
+
+    auto frozen = std::make_shared<const frozen_graph<int>>(std::vector<int> {1, 2}, std::vector<frozen_edge> {});
+    auto rejected = false;
+    try {
+        shortest_path_tree<int>(frozen, 0, {0.0}, {no_node});
+    } catch(std::domain_error &) {
+        rejected = true;
+    }
+    assert(rejected);
+}
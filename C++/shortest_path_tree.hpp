@@ -0,0 +1,365 @@
+#ifndef SHORTEST_PATH_TREE_H
+#define SHORTEST_PATH_TREE_H
+
+#include <algorithm>
+#include <cmath>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <stdexcept>
+#include <vector>
+
+#include "delta_stepping.hpp"
+#include "dijkstra_workspace.hpp"
+#include "frozen_graph.hpp"
+
+// The complete result of a single source shortest path run, kept in plain
+// arrays indexed by node id:  a distance and a parent per node.  Walking
+// parents from a node back to the source gives the path to it, so a single
+// tree answers "how far, and which way" for every target at once, without
+// a hash lookup anywhere.
+//
+// path_to is O(path length):  one walk up the parents counts the edges,
+// and a second writes the path straight into place from the target end,
+// with no reversing and no growing the buffer.
+//
+// On top of the parents, the tree is laid out in preorder (a node, then all
+// of its subtree, then its next sibling's).  That makes subtree queries
+// O(1):  a node's subtree is a contiguous run of the preorder, so
+// subtree(u) is just a span of it, and "is v below u" is two comparisons.
+// (Which targets does this edge lie on the way to?  Exactly the subtree
+// below it.)  The layout is built by the constructor, and after a repair
+// it is rebuilt (one linear pass) by the first call that needs it, so a
+// tree that is repaired over and over but rarely asked about subtrees
+// doesn't pay for it each time.  That rebuild is thread safe, like the
+// rest of the const members.
+//
+// The tree holds on to the frozen graph it was computed on, for mapping
+// node ids to names, and for repair() to read the current weights from.
+
+template <class T>
+class shortest_path_tree {
+private:
+    std::shared_ptr<const frozen_graph<T>> working_graph;
+    node_id source_node;
+    std::vector<double> distances;
+    std::vector<node_id> parents;
+
+    // preorder[position[u]] == u, and u's subtree is preorder[position[u]]
+    // up to (but not including) preorder[position[u] + subtree_sizes[u]].
+    // Unreached nodes aren't in the preorder, and have position no_node.
+    // Only valid once indexed has fired;  repair replaces the flag.
+    mutable std::vector<node_id> preorder;
+    mutable std::vector<node_id> position;
+    mutable std::vector<node_id> subtree_sizes;
+    mutable std::vector<node_id> depths;
+    std::unique_ptr<std::once_flag> indexed = std::make_unique<std::once_flag>();
+
+    // repair's scratch space, kept between calls so a small repair costs
+    // nothing in proportion to the graph:  is_cut is all false, and cut and
+    // queue empty, between calls.
+    std::vector<bool> is_cut;
+    std::vector<node_id> cut;
+
+    void index() const {
+        auto n = working_graph->node_count();
+        // The children of every node, in CSR form (a counting sort on parents).
+        auto child_offsets = std::vector<node_id>(n + 1, 0);
+        for(node_id u = 0; u < n; ++u) {
+            if(parents[u] != no_node) {
+                child_offsets[parents[u] + 1]++;
+            }
+        }
+        for(node_id u = 0; u < n; ++u) {
+            child_offsets[u + 1] += child_offsets[u];
+        }
+        auto children = std::vector<node_id>(child_offsets[n]);
+        auto fill = std::vector<node_id>(child_offsets.begin(), child_offsets.end() - 1);
+        for(node_id u = 0; u < n; ++u) {
+            if(parents[u] != no_node) {
+                children[fill[parents[u]]++] = u;
+            }
+        }
+
+        // Preorder with an explicit stack (the tree can be as deep as the
+        // graph is big, far too deep to recurse).
+        position.assign(n, no_node);
+        depths.assign(n, 0);
+        subtree_sizes.assign(n, 0);
+        preorder.clear();
+        auto stack = std::vector<node_id> {source_node};
+        while(!stack.empty()) {
+            auto u = stack.back();
+            stack.pop_back();
+            position[u] = node_id(preorder.size());
+            preorder.push_back(u);
+            for(auto k = child_offsets[u + 1]; k > child_offsets[u]; --k) {
+                auto child = children[k - 1];
+                depths[child] = depths[u] + 1;
+                stack.push_back(child);
+            }
+        }
+        // Children come after their parents in preorder, so going
+        // backwards adds each finished subtree into its parent's.
+        for(auto k = preorder.size(); k > 0; --k) {
+            auto u = preorder[k - 1];
+            subtree_sizes[u]++;
+            if(u != source_node) {
+                subtree_sizes[parents[u]] += subtree_sizes[u];
+            }
+        }
+    }
+
+    struct queue_entry {
+        double distance;
+        node_id node;
+
+        bool operator<(const queue_entry &other) const {
+            return distance > other.distance;
+        }
+    };
+
+    std::vector<queue_entry> queue;
+
+    void check(node_id node) const {
+        if(node >= distances.size()) {
+            throw std::logic_error("Unable to find the node");
+        }
+    }
+
+    void ensure_index() const {
+        std::call_once(*indexed, [this] { index(); });
+    }
+
+public:
+    // From distances and parents computed elsewhere.  parent must be no_node
+    // for the source and for unreached nodes, and must form a tree.
+    shortest_path_tree(std::shared_ptr<const frozen_graph<T>> g, node_id source,
+                       std::vector<double> distance, std::vector<node_id> parent) :
+    working_graph(std::move(g)), source_node(source), distances(std::move(distance)), parents(std::move(parent)) {
+        auto n = working_graph->node_count();
+        if(distances.size() != n || parents.size() != n || source_node >= n) {
+            throw std::domain_error("Shortest path result doesn't match the graph");
+        }
+        ensure_index();
+    }
+
+    // From a delta_stepping result.
+    shortest_path_tree(std::shared_ptr<const frozen_graph<T>> g, node_id source, sssp_result result) :
+    shortest_path_tree(std::move(g), source, std::move(result.distance), std::move(result.parent)) {
+    }
+
+    const frozen_graph<T> &frozen() const {
+        return *working_graph;
+    }
+
+    node_id source() const {
+        return source_node;
+    }
+
+    // +infinity if node can't be reached from the source.
+    double distance(node_id node) const {
+        check(node);
+        return distances[node];
+    }
+
+    double distance(const T &name) const {
+        return distances[working_graph->id(name)];
+    }
+
+    // no_node for the source and for unreached nodes.
+    node_id parent(node_id node) const {
+        check(node);
+        return parents[node];
+    }
+
+    bool reached(node_id node) const {
+        check(node);
+        return distances[node] != HUGE_VAL;
+    }
+
+    // The number of edges on the path from the source to node.
+    node_id depth(node_id node) const {
+        check(node);
+        ensure_index();
+        return depths[node];
+    }
+
+    // Writes the path from the source to target (both included) into path,
+    // and returns its length.  If path is too small nothing is written, and
+    // the length it needs is returned;  0 means target wasn't reached.
+    size_t path_to(node_id target, std::span<node_id> path) const {
+        if(!reached(target)) {
+            return 0;
+        }
+        size_t length = 0;
+        for(auto node = target; node != no_node; node = parents[node]) {
+            length++;
+        }
+        if(path.size() < length) {
+            return length;
+        }
+        auto k = length;
+        for(auto node = target; node != no_node; node = parents[node]) {
+            path[--k] = node;
+        }
+        return length;
+    }
+
+    // The same, reusing path's storage (and growing it if needed).
+    void path_to(node_id target, std::vector<node_id> &path) const {
+        path.resize(path_to(target, std::span<node_id>()));
+        path_to(target, std::span<node_id>(path));
+    }
+
+    // Every node whose shortest path goes through root (root included), in
+    // preorder.  Empty if root wasn't reached.
+    std::span<const node_id> subtree(node_id root) const {
+        if(!reached(root)) {
+            return {};
+        }
+        ensure_index();
+        return {preorder.data() + position[root], subtree_sizes[root]};
+    }
+
+    // Whether the shortest path to node goes through ancestor.
+    bool in_subtree(node_id ancestor, node_id node) const {
+        if(!reached(ancestor) || !reached(node)) {
+            return false;
+        }
+        ensure_index();
+        return position[node] >= position[ancestor] &&
+               position[node] < position[ancestor] + subtree_sizes[ancestor];
+    }
+
+    // Brings the tree up to date after the weights of the changed edges
+    // have been changed in the graph (up or down, any mix), without
+    // starting over.  This is Ramalingam and Reps' approach ("An Incremental
+    // Algorithm for a Generalization of the Shortest-Path Problem", 1996):
+    //
+    // - A tree edge that got heavier may lengthen the path to everything
+    //   below it, so that whole subtree (a span of the preorder) is cut
+    //   loose.  Each cut node then gets the best distance it can reach
+    //   directly from the part of the tree that is still intact, through its
+    //   in edges.
+    // - An edge that got lighter may offer a shorter way to its end.
+    //
+    // Then a Dijkstra seeded with just those nodes settles everything that
+    // actually changed.  Nodes whose distance doesn't change are never
+    // touched, so a small change costs a small search:  the cut subtrees
+    // are found by following out edges to the nodes whose parent is the
+    // current one (rather than through the preorder, which may be stale
+    // from the last repair), and the scratch space is kept, so nothing
+    // here is in proportion to the whole graph.  The distances come out
+    // exactly as a fresh run would give them;  where there are ties the
+    // parents may differ.  The one linear cost left is the preorder
+    // rebuild, which waits for the next depth, subtree or in_subtree call.
+    //
+    // Returns how many nodes had their distance recomputed.
+    size_t repair(std::span<const edge_id> changed) {
+        auto &g = *working_graph;
+        is_cut.resize(distances.size(), false);
+        for(auto edge : changed) {
+            auto start = g.edge_start(edge);
+            auto end = g.edge_end(edge);
+            if(parents[end] != start || is_cut[end]) {
+                continue;
+            }
+            // The tree might be using another (parallel) edge from start, so
+            // only cut if no edge from start still gives the same distance.
+            auto holds = false;
+            g.for_each_out_edge(start, [&](node_id next, double weight) {
+                holds = holds || (next == end && distances[start] + weight == distances[end]);
+            });
+            if(holds) {
+                continue;
+            }
+            // Cut nodes are always whole subtrees, so a node already cut
+            // (inside another cut subtree) has its whole subtree cut too.
+            auto first = cut.size();
+            is_cut[end] = true;
+            cut.push_back(end);
+            for(auto k = first; k < cut.size(); ++k) {
+                auto u = cut[k];
+                g.for_each_out_edge(u, [&](node_id next, double) {
+                    if(parents[next] == u && !is_cut[next]) {
+                        is_cut[next] = true;
+                        cut.push_back(next);
+                    }
+                });
+            }
+        }
+
+        auto offer = [&](node_id node, double distance, node_id parent) {
+            if(distance < distances[node]) {
+                distances[node] = distance;
+                parents[node] = parent;
+                queue.push_back({distance, node});
+                std::push_heap(queue.begin(), queue.end());
+            }
+        };
+        for(auto u : cut) {
+            distances[u] = HUGE_VAL;
+            parents[u] = no_node;
+        }
+        for(auto u : cut) {
+            g.for_each_in_edge(u, [&](node_id previous, double weight) {
+                if(!is_cut[previous] && distances[previous] != HUGE_VAL) {
+                    offer(u, distances[previous] + weight, previous);
+                }
+            });
+        }
+        for(auto edge : changed) {
+            auto start = g.edge_start(edge);
+            if(!is_cut[start] && distances[start] != HUGE_VAL) {
+                offer(g.edge_end(edge), distances[start] + g.weight(edge), start);
+            }
+        }
+
+        size_t recomputed = 0;
+        while(!queue.empty()) {
+            std::pop_heap(queue.begin(), queue.end());
+            auto entry = queue.back();
+            queue.pop_back();
+            if(entry.distance > distances[entry.node]) {
+                continue;
+            }
+            recomputed++;
+            g.for_each_out_edge(entry.node, [&](node_id next, double weight) {
+                offer(next, entry.distance + weight, entry.node);
+            });
+        }
+        for(auto u : cut) {
+            is_cut[u] = false;
+        }
+        cut.clear();
+        indexed = std::make_unique<std::once_flag>();
+        return recomputed;
+    }
+};
+
+// Runs Dijkstra from source over the whole graph and returns the tree.
+template <class T>
+shortest_path_tree<T> build_shortest_path_tree(std::shared_ptr<const frozen_graph<T>> g, node_id source,
+                                               dijkstra_workspace &workspace) {
+    workspace.run(*g, source);
+    auto n = g->node_count();
+    auto distance = std::vector<double>(n);
+    auto parent = std::vector<node_id>(n);
+    for(node_id u = 0; u < n; ++u) {
+        distance[u] = workspace.distance(u);
+        parent[u] = workspace.parent(u);
+    }
+    return shortest_path_tree<T>(std::move(g), source, std::move(distance), std::move(parent));
+}
+
+template <class T>
+shortest_path_tree<T> build_shortest_path_tree(std::shared_ptr<const frozen_graph<T>> g, const T &source) {
+    auto workspace = dijkstra_workspace();
+    auto id = g->id(source);
+    return build_shortest_path_tree(std::move(g), id, workspace);
+}
+
+void testShortestPathTree();
+
+#endif //SHORTEST_PATH_TREE_H
@@ -0,0 +1,203 @@
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// A small persistent thread pool for the parallel algorithms.
+//
+// Starting a std::thread costs tens of microseconds, which is far too much
+// to pay every time a parallel algorithm wants to split up a loop (delta
+// stepping does so several times per bucket).  So instead the pool starts
+// its threads once, and they sleep on a condition variable until there is
+// a job for them.
+//
+// The only operation is parallel_for(n, f), which calls f(worker, i) for
+// every i in [0, n) and returns once they are all done.  The worker number
+// is in [0, size()), and no two calls running at the same time share a
+// worker number, so callers can use it to index per-thread scratch space
+// without any locking.
+//
+// The range is scheduled by work stealing.  Each worker starts out owning
+// an equal contiguous slice of [0, n), and takes chunks off the front of
+// its own slice, so neighbouring indices (which tend to touch neighbouring
+// memory) stay on one thread.  A worker that runs dry picks another worker
+// and steals the back half of whatever that worker has left.  So when some
+// items are far more expensive than others (one shortest path query can
+// explore the whole graph while the next stops after a few nodes) the idle
+// threads pick up the slack, and there is no single shared counter for
+// every thread to fight over.
+class thread_pool {
+private:
+    // The part of the index range a worker still owns.  These are padded
+    // out to a cache line each so that workers taking chunks from their
+    // own slices do not slow each other down.
+    struct alignas(64) work_range {
+        std::mutex mutex;
+        size_t begin = 0;
+        size_t end = 0;
+    };
+
+    std::vector<std::thread> workers;
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::condition_variable done;
+    std::function<void(unsigned)> job;
+    size_t generation = 0;
+    unsigned active = 0;
+    bool stopping = false;
+
+    // Only one parallel_for can own the workers at a time.
+    std::mutex run_mutex;
+
+    void worker_loop(unsigned worker) {
+        size_t seen = 0;
+        while(true) {
+            std::function<void(unsigned)> current;
+            {
+                std::unique_lock lock(mutex);
+                wake.wait(lock, [&] { return stopping || generation != seen; });
+                if(stopping) {
+                    return;
+                }
+                seen = generation;
+                current = job;
+            }
+            current(worker);
+            {
+                std::unique_lock lock(mutex);
+                if(--active == 0) {
+                    done.notify_all();
+                }
+            }
+        }
+    }
+
+    // Runs job(worker) once on every worker and waits for them all.
+    void run_on_all(std::function<void(unsigned)> work) {
+        std::unique_lock lock(mutex);
+        job = std::move(work);
+        active = size();
+        ++generation;
+        wake.notify_all();
+        done.wait(lock, [&] { return active == 0; });
+        job = nullptr;
+    }
+
+public:
+    explicit thread_pool(unsigned threads = std::thread::hardware_concurrency()) {
+        if(threads == 0) {
+            threads = 1;
+        }
+        for(unsigned i = 0; i < threads; ++i) {
+            workers.emplace_back([this, i] { worker_loop(i); });
+        }
+    }
+
+    thread_pool(const thread_pool &) = delete;
+    thread_pool &operator=(const thread_pool &) = delete;
+
+    ~thread_pool() {
+        {
+            std::unique_lock lock(mutex);
+            stopping = true;
+        }
+        wake.notify_all();
+        for(auto &t : workers) {
+            t.join();
+        }
+    }
+
+    unsigned size() const {
+        return static_cast<unsigned>(workers.size());
+    }
+
+    // Calls f(worker, i) for every i in [0, n).  Indices are handed out in
+    // chunks of at most grain.  If any call throws, the remaining work is
+    // abandoned and the first exception is rethrown here.
+    template <class F>
+    void parallel_for(size_t n, F &&f, size_t grain = 64) {
+        if(n == 0) {
+            return;
+        }
+        if(grain == 0) {
+            grain = 1;
+        }
+        std::unique_lock run_lock(run_mutex);
+        auto count = size();
+        auto ranges = std::vector<work_range>(count);
+        for(unsigned w = 0; w < count; ++w) {
+            ranges[w].begin = n * w / count;
+            ranges[w].end = n * (w + 1) / count;
+        }
+        std::atomic<bool> failed = false;
+        std::exception_ptr error = nullptr;
+        std::mutex error_mutex;
+
+        // Takes the next chunk from the worker's own slice, or failing that
+        // steals half of somebody else's.  Returns false once everything
+        // has been handed out.
+        auto next_chunk = [&](unsigned worker, size_t &begin, size_t &end) {
+            {
+                auto &own = ranges[worker];
+                std::unique_lock lock(own.mutex);
+                if(own.begin < own.end) {
+                    begin = own.begin;
+                    end = std::min(own.end, begin + grain);
+                    own.begin = end;
+                    return true;
+                }
+            }
+            for(unsigned offset = 1; offset < count; ++offset) {
+                auto &victim = ranges[(worker + offset) % count];
+                size_t stolen_begin, stolen_end;
+                {
+                    std::unique_lock lock(victim.mutex);
+                    if(victim.begin >= victim.end) {
+                        continue;
+                    }
+                    stolen_end = victim.end;
+                    stolen_begin = victim.begin + (victim.end - victim.begin) / 2;
+                    victim.end = stolen_begin;
+                }
+                auto &own = ranges[worker];
+                std::unique_lock lock(own.mutex);
+                begin = stolen_begin;
+                end = std::min(stolen_end, begin + grain);
+                own.begin = end;
+                own.end = stolen_end;
+                return true;
+            }
+            return false;
+        };
+
+        run_on_all([&](unsigned worker) {
+            size_t begin, end;
+            while(!failed.load(std::memory_order_relaxed) && next_chunk(worker, begin, end)) {
+                try {
+                    for(auto i = begin; i < end; ++i) {
+                        f(worker, i);
+                    }
+                } catch(...) {
+                    std::unique_lock lock(error_mutex);
+                    if(error == nullptr) {
+                        error = std::current_exception();
+                    }
+                    failed = true;
+                    return;
+                }
+            }
+        });
+        if(error != nullptr) {
+            std::rethrow_exception(error);
+        }
+    }
+};
+
+#endif //THREAD_POOL_H
@@ -0,0 +1,79 @@
+#include "traversal_generator.hpp"
+
+#include <cassert>
+#include <ranges>
+
+#include "graph_generators.hpp"
+
+static_assert(std::ranges::input_range<dijkstra_step_generator<int>>);
+
+// The coroutine version has to produce exactly what the iterator version
+// does, step for step, including which of several equally distant nodes
+// comes first (so the weights here are small integers, to make lots of
+// ties).  We also check that a frame_arena really does hold the frame, and
+// that stopping early and bad start nodes behave.
+
+void testTraversalGenerator() {
+    std::cerr << "Initializing traversal generator tests" << std::endl;
+    for(auto k = 0; k < 10; ++k) {
+        auto generated = erdos_renyi_graph(100, 3, k);
+        use_whole_weights(generated, 4);
+        auto g = build_graph<int>(generated);
+
+        auto expected = std::vector<std::shared_ptr<dijkstra_iteration_step<int>>>();
+        for(auto step : dijkstra_traversal<int>(g, 0)) {
+            expected.push_back(step);
+        }
+        auto check = [&](auto &&traversal) {
+            size_t i = 0;
+            for(auto &step : traversal) {
+                assert(i < expected.size());
+                assert(step->current == expected[i]->current);
+                assert(step->distance == expected[i]->distance);
+                assert(step->previous == expected[i]->previous);
+                i++;
+            }
+            assert(i == expected.size());
+        };
+        check(dijkstra_generator<int>(g, 0));
+
+        alignas(std::max_align_t) std::byte buffer[4096];
+        auto arena = frame_arena(buffer);
+        {
+            auto traversal = dijkstra_generator<int>(std::allocator_arg, arena, g, 0);
+            assert(arena.used() > 0);
+            check(traversal);
+        }
+        assert(arena.used() == 0);
+    }
+
+    // Lazy:  stopping after the first step is fine, and a missing start
+    // node is only noticed once the traversal starts.
+    auto g = std::make_shared<graph<int>>();
+    g->create_node(0);
+    g->create_node(1);
+    g->create_link(0, 1, 1.0);
+    for(auto &step : dijkstra_generator<int>(g, 0)) {
+        assert(step->current->name == 0);
+        break;
+    }
+    auto traversal = dijkstra_generator<int>(g, 5);
+    auto failed = false;
+    try {
+        traversal.begin();
+    } catch(std::logic_error &) {
+        failed = true;
+    }
+    assert(failed);
+
+    // A frame too big for its arena still works, from the per-thread cache.
+    alignas(std::max_align_t) std::byte tiny[16];
+    auto small_arena = frame_arena(tiny);
+    auto steps = 0;
+    for(auto &step : dijkstra_generator<int>(std::allocator_arg, small_arena, g, 0)) {
+        assert(step->distance == steps);
+        steps++;
+    }
+    assert(steps == 2);
+    assert(small_arena.used() == 0);
+}
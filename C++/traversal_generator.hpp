@@ -0,0 +1,83 @@
+#ifndef TRAVERSAL_GENERATOR_H
+#define TRAVERSAL_GENERATOR_H
+
+#include "generator.hpp"
+#include "graph.hpp"
+
+// The Dijkstra traversal again, but written as a coroutine.  Set this side
+// by side with dijkstra_traversal_iterator:  it is exactly the same
+// algorithm (and, given the same graph, it produces exactly the same steps
+// in exactly the same order), but here the loop is just a loop.  The
+// iterator's constructor becomes the code before the loop, its iter()
+// becomes the loop body, and its member variables become local variables.
+// A new kind of traversal is just a new function like this one.
+//
+// The usage is the same as dijkstra_traversal:
+//
+// for(auto step : dijkstra_generator<int>(g, 0)) { ... }
+//
+// or, to put the coroutine's frame in a buffer of your own:
+//
+// alignas(std::max_align_t) std::byte buffer[1024];
+// auto arena = frame_arena(buffer);
+// for(auto step : dijkstra_generator<int>(std::allocator_arg, arena, g, 0)) { ... }
+
+template <class T>
+using dijkstra_step_generator = generator<std::shared_ptr<dijkstra_iteration_step<T>>>;
+
+// The coroutine itself lives in a struct only so that graph<T> and
+// graph_node<T> can name it as a friend.
+template <class T>
+struct dijkstra_coroutine {
+    static dijkstra_step_generator<T> traverse(std::shared_ptr<const graph<T>> working_graph, T start) {
+        if(!working_graph->nodes.contains(start)) {
+            throw std::logic_error("Unable to find the node");
+        }
+        std::unordered_map<std::shared_ptr<graph_node<T>>,
+                           std::shared_ptr<dijkstra_iteration_step<T>>> working_set;
+        for(auto itr : working_graph->nodes) {
+            auto element = std::make_shared<dijkstra_iteration_step<T>>(itr.second);
+            if (itr.first == start) {
+                element->distance = 0;
+            }
+            working_set[itr.second] = element;
+        }
+        while(working_set.size() != 0) {
+            std::shared_ptr<dijkstra_iteration_step<T>> current_node = nullptr;
+            for (auto itr: working_set) {
+                if(current_node == nullptr || itr.second->distance < current_node->distance) {
+                    current_node = itr.second;
+                }
+            }
+            working_set.erase(current_node->current);
+            if(current_node->distance == HUGE_VAL) {
+                co_return;
+            }
+            for (auto itr : current_node->current->out_edges) {
+                if(working_set.contains(itr->end)) {
+                    auto distance = current_node->distance + itr->weight;
+                    if(distance < working_set[itr->end]->distance) {
+                        working_set[itr->end]->distance = distance;
+                        working_set[itr->end]->previous = current_node->current;
+                    }
+                }
+            }
+            co_yield current_node;
+        }
+    }
+};
+
+template <class T>
+dijkstra_step_generator<T> dijkstra_generator(std::shared_ptr<const graph<T>> g, T start) {
+    return dijkstra_coroutine<T>::traverse(g, start);
+}
+
+template <class T>
+dijkstra_step_generator<T> dijkstra_generator(std::allocator_arg_t, frame_arena &arena,
+                                              std::shared_ptr<const graph<T>> g, T start) {
+    return with_frame_arena(arena, [&] { return dijkstra_coroutine<T>::traverse(g, start); });
+}
+
+void testTraversalGenerator();
+
+#endif //TRAVERSAL_GENERATOR_H
@@ -0,0 +1,75 @@
+#include "traversal_stats.hpp"
+
+#include <cassert>
+#include <iostream>
+
+#include "dijkstra_workspace.hpp"
+#include "graph.hpp"
+#include "graph_generators.hpp"
+
+// Switched off, the recorder takes no space at all.
+static_assert(std::is_empty_v<traversal_recorder<false>>);
+static_assert(sizeof(dijkstra_traversal<int>) == sizeof(dijkstra_traversal<int, true>) - sizeof(traversal_recorder<true>));
+static_assert(std::input_iterator<dijkstra_traversal_iterator<int, true>>);
+static_assert(std::ranges::view<dijkstra_traversal<int, true>>);
+
+void testTraversalStats() {
+    std::cerr << "Initializing traversal stats tests" << std::endl;
+
+    // 0 -> 1 -> 2 costs 2, the direct 0 -> 2 link costs 5 but is seen
+    // first, so 2's distance gets lowered once.  3 is unreachable.
+    auto g = std::make_shared<graph<int>>();
+    for(auto i = 0; i < 4; ++i) {
+        g->create_node(i);
+    }
+    g->create_link(0, 2, 5);
+    g->create_link(0, 1, 1);
+    g->create_link(1, 2, 1);
+    g->create_link(2, 0, 1);
+    g->create_link(3, 0, 1);
+
+    auto stats = traversal_stats();
+    auto count = 0;
+    for(auto &step : dijkstra_traversal<int, true>(g, 0, stats)) {
+        assert(step->distance == count);
+        count++;
+    }
+    assert(count == 3);
+    assert(stats.nodes_settled == 3 && stats.queue_pops == 3);
+    assert(stats.edges_relaxed == 4);
+    assert(stats.queue_pushes == 3 && stats.decrease_keys == 1);
+    assert(stats.peak_frontier == 2);
+
+    // The workspace's lazy deletion heap pushes a second entry for 2 and
+    // pops the stale one, and the counts carry on from the last run.
+    auto names = std::vector<int> {0, 1, 2, 3};
+    auto edges = std::vector<frozen_edge> {{0, 2, 5}, {0, 1, 1}, {1, 2, 1}, {2, 0, 1}, {3, 0, 1}};
+    auto frozen = frozen_graph<int>(names, edges);
+    auto workspace = dijkstra_workspace();
+    workspace.run(frozen, 0, stats);
+    assert(stats.nodes_settled == 6 && stats.edges_relaxed == 8 && stats.decrease_keys == 2);
+    assert(stats.queue_pushes == 7 && stats.queue_pops == 7);
+
+    // A bigger graph:  the instrumented and plain runs agree, and the
+    // counts hang together.
+    const int n = 2000;
+    auto big = freeze<int>(erdos_renyi_graph(n, 4));
+    auto plain = dijkstra_workspace();
+    plain.run(big, 0);
+    stats.clear();
+    workspace.run(big, 0, stats);
+    assert(stats.nodes_settled == plain.settled_count());
+    for(node_id u = 0; u < big.node_count(); ++u) {
+        assert(workspace.distance(u) == plain.distance(u));
+    }
+    assert(stats.queue_pushes == stats.queue_pops);
+    assert(stats.queue_pushes == stats.nodes_settled + stats.decrease_keys);
+    assert(stats.edges_relaxed >= stats.queue_pushes - 1);
+    assert(stats.peak_frontier > 0 && stats.peak_frontier < stats.queue_pushes);
+    assert(stats.search_time.count() > 0);
+
+    // Stopping early leaves entries in the queue.
+    stats.clear();
+    workspace.run(big, 0, stats, n / 2);
+    assert(stats.queue_pops <= stats.queue_pushes);
+}
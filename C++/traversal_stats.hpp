@@ -0,0 +1,136 @@
+#ifndef TRAVERSAL_STATS_H
+#define TRAVERSAL_STATS_H
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <ostream>
+
+// Counters for working out why a query is slow.
+//
+// A traversal that is asked to (dijkstra_traversal<T, true>,
+// bfs_traversal<T, true>, or dijkstra_workspace::run and
+// direction_optimizing_bfs given a traversal_stats) adds what it did to a
+// traversal_stats:  how many nodes it settled and edges it relaxed, what
+// the priority queue went through, and where the time went.  The counts
+// accumulate over runs until clear() is called, so one struct can total up
+// a whole batch of queries.
+//
+// The engines don't touch the stats directly, but through a
+// traversal_recorder<Instrumented>.  traversal_recorder<false> is an empty
+// class whose every member does nothing, so an uninstrumented traversal
+// compiles to exactly the code it would be without any of this (and,
+// being [[no_unique_address]], the recorder doesn't even take up space).
+// The counting calls take a count, for engines that work a level at a
+// time and so know how many nodes or edges they went through at once.
+
+struct traversal_stats {
+    // Nodes whose distance became final.
+    size_t nodes_settled = 0;
+    // Edges looked at out of settled nodes.
+    size_t edges_relaxed = 0;
+    // Times a node already in the frontier got a shorter distance.  With a
+    // lazy deletion heap each one is also a push, leaving a stale entry.
+    size_t decrease_keys = 0;
+    size_t queue_pushes = 0;
+    // Including the stale entries popped and thrown away.
+    size_t queue_pops = 0;
+    // The most nodes (or queue entries) waiting to be settled at once.
+    size_t peak_frontier = 0;
+    // Setting up a run (allocating and initialising the per node state)
+    // versus the search itself.
+    std::chrono::nanoseconds setup_time {0};
+    std::chrono::nanoseconds search_time {0};
+
+    void clear() {
+        *this = traversal_stats();
+    }
+};
+
+inline std::ostream &operator<<(std::ostream &out, const traversal_stats &stats) {
+    return out << stats.nodes_settled << " settled, " << stats.edges_relaxed << " relaxed, "
+               << stats.decrease_keys << " decrease-keys, " << stats.queue_pushes << " pushes, "
+               << stats.queue_pops << " pops, peak frontier " << stats.peak_frontier << ", setup "
+               << std::chrono::duration<double, std::micro>(stats.setup_time).count() << " us, search "
+               << std::chrono::duration<double, std::micro>(stats.search_time).count() << " us";
+}
+
+template <bool Instrumented>
+class traversal_recorder;
+
+template <>
+class traversal_recorder<false> {
+public:
+    struct time_point {
+    };
+
+    traversal_recorder() = default;
+
+    time_point now() const {
+        return {};
+    }
+    void add_setup_time(time_point) const {
+    }
+    void add_search_time(time_point) const {
+    }
+    void settled(size_t = 1) const {
+    }
+    void relaxed(size_t = 1) const {
+    }
+    void decreased_key() const {
+    }
+    void pushed(size_t = 1) const {
+    }
+    void popped(size_t = 1) const {
+    }
+};
+
+template <>
+class traversal_recorder<true> {
+private:
+    traversal_stats *stats = nullptr;
+    // Queue entries pushed less popped in the current run.
+    size_t frontier = 0;
+
+public:
+    using time_point = std::chrono::steady_clock::time_point;
+
+    // Only so that an iterator already at the end can be default
+    // constructed:  it never records anything.
+    traversal_recorder() = default;
+
+    explicit traversal_recorder(traversal_stats &statsIn) : stats(&statsIn) {
+    }
+
+    time_point now() const {
+        return std::chrono::steady_clock::now();
+    }
+    void add_setup_time(time_point started) const {
+        stats->setup_time += now() - started;
+    }
+    void add_search_time(time_point started) const {
+        stats->search_time += now() - started;
+    }
+    void settled(size_t count = 1) const {
+        stats->nodes_settled += count;
+    }
+    void relaxed(size_t count = 1) const {
+        stats->edges_relaxed += count;
+    }
+    void decreased_key() const {
+        stats->decrease_keys++;
+    }
+    void pushed(size_t count = 1) {
+        stats->queue_pushes += count;
+        frontier += count;
+        stats->peak_frontier = std::max(stats->peak_frontier, frontier);
+    }
+    void popped(size_t count = 1) {
+        stats->queue_pops += count;
+        frontier -= count;
+    }
+};
+
+void testTraversalStats();
+
+#endif //TRAVERSAL_STATS_H
@@ -0,0 +1,84 @@
+#include "versioned_graph.hpp"
+
+#include <cassert>
+#include <thread>
+#include <vector>
+
+// A writer grows a chain 0 -> 1 -> 2 -> ... one node per update while
+// reader threads keep taking snapshots and traversing them.  Version v of
+// the graph is always exactly the chain 0..v-1, so every traversal a
+// reader does has to see exactly that:  v steps, at distances 0..v-1.  If
+// a reader ever saw a half-applied update (a node without its link) the
+// traversal would come up short.
+
+void testVersionedGraph() {
+    std::cerr << "Initializing versioned graph tests" << std::endl;
+    auto versions = versioned_graph<int>();
+    assert(versions.snapshot()->version == 0);
+
+    const int updates = 100;
+    std::atomic<bool> finished = false;
+    auto readers = std::vector<std::thread>();
+    for(auto r = 0; r < 3; ++r) {
+        readers.emplace_back([&] {
+            std::uint64_t last = 0;
+            while(!finished.load()) {
+                auto snapshot = versions.snapshot();
+                assert(snapshot->version >= last);
+                last = snapshot->version;
+                if(last == 0) {
+                    continue;
+                }
+                int i = 0;
+                for(auto step : dijkstra_traversal<int>(snapshot->working_graph, 0)) {
+                    assert(step->current->name == i);
+                    assert(step->distance == double(i));
+                    i++;
+                }
+                assert(i == int(last));
+            }
+        });
+    }
+
+    for(auto k = 0; k < updates; ++k) {
+        auto published = versions.update([k](graph<int> &g) {
+            g.create_node(k);
+            if(k > 0) {
+                g.create_link(k - 1, k, 1.0);
+            }
+        });
+        assert(published->version == std::uint64_t(k + 1));
+    }
+
+    // An update that fails part way through publishes nothing.
+    auto before = versions.snapshot();
+    auto failed = false;
+    try {
+        versions.update([](graph<int> &g) {
+            g.create_node(updates);
+            g.create_node(updates);
+        });
+    } catch(std::domain_error &) {
+        failed = true;
+    }
+    assert(failed);
+    assert(versions.snapshot() == before);
+
+    finished = true;
+    for(auto &reader : readers) {
+        reader.join();
+    }
+
+    // Old snapshots stay valid and unchanged after newer versions appear.
+    auto old = before;
+    versions.update([](graph<int> &g) {
+        g.create_node(updates);
+        g.create_link(updates - 1, updates, 1.0);
+    });
+    int i = 0;
+    for(auto step : dijkstra_traversal<int>(old->working_graph, 0)) {
+        assert(step->current->name == i);
+        i++;
+    }
+    assert(i == updates);
+}
@@ -0,0 +1,80 @@
+#ifndef VERSIONED_GRAPH_H
+#define VERSIONED_GRAPH_H
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+
+#include "graph.hpp"
+
+// graph<T> itself has no locking at all, so sharing one between threads
+// that modify it and threads that traverse it needs something on top.
+// Wrapping every access in one mutex works, but then every reader waits
+// for every writer (and a big batch of create_link calls can take a while).
+//
+// versioned_graph instead uses a read-copy-update scheme.  The graph that
+// readers see is an immutable published version.  A reader grabs the
+// current version with snapshot(), which is just copying one shared_ptr,
+// and can then traverse it for as long as it likes:  nothing will ever
+// modify it.  A writer calls update() with a function that makes its
+// changes;  those are applied to a fresh copy of the current version, and
+// when the function returns the copy is published as the new current
+// version in a single atomic pointer swap.  Readers that started before
+// the swap carry on with the old version, readers that start after it get
+// the new one, and no reader ever sees a half-applied batch.
+//
+// Reclaiming old versions is the tricky part of any RCU scheme:  an old
+// version can only be freed once no reader is still using it.  Here the
+// shared_ptr reference count does that job.  Each reader's snapshot holds
+// a reference, so an old version is freed exactly when the last reader
+// that took it lets go, by whichever thread happens to drop that last
+// reference.
+//
+// The price is on the write side:  every update() copies the whole graph,
+// so writers should batch their changes into as few updates as they can.
+// Writers are serialized with each other, but never wait for readers.
+
+template <class T>
+struct graph_version {
+    // Counts up from 0 (the empty graph) with every published update.
+    const std::uint64_t version;
+    const std::shared_ptr<const graph<T>> working_graph;
+};
+
+template <class T>
+class versioned_graph {
+private:
+    std::atomic<std::shared_ptr<const graph_version<T>>> current;
+    std::mutex writer_mutex;
+
+public:
+    versioned_graph() :
+    current(std::make_shared<const graph_version<T>>(0, std::make_shared<const graph<T>>())) {
+    }
+
+    // The current version.  Cheap, never blocks behind a writer's batch,
+    // and the result stays valid (and unchanging) for as long as it is held.
+    std::shared_ptr<const graph_version<T>> snapshot() const {
+        return current.load(std::memory_order_acquire);
+    }
+
+    // Applies a batch of changes and publishes the result.  f is called with
+    // a graph<T> & to modify (a private copy of the current version).  If f
+    // throws, nothing is published and the exception propagates.  Returns
+    // the newly published version.
+    template <class F>
+    std::shared_ptr<const graph_version<T>> update(F &&f) {
+        std::unique_lock lock(writer_mutex);
+        auto previous = current.load(std::memory_order_relaxed);
+        auto next = std::make_shared<graph<T>>(*previous->working_graph);
+        f(*next);
+        auto published = std::make_shared<const graph_version<T>>(previous->version + 1, std::move(next));
+        current.store(published, std::memory_order_release);
+        return published;
+    }
+};
+
+void testVersionedGraph();
+
+#endif //VERSIONED_GRAPH_H